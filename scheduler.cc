@@ -2,24 +2,42 @@
 
 #include "scheduler.h"
 
+#include "search_checkpoint.h"
+#include "search_profile.h"
+#include "solver_telemetry.h"
+
+#include <stdint.h>
+
+#include <climits>
 #include <cstdio>
 
 #include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <random>
+#include <thread>
 #include <vector>
 
 namespace {
 
+// The number of states between two polls for telemetry and checkpoints.
+const int kPollInterval = 1 << 16;
+
 struct CourseComparator {
   const std::vector<int> &current_price_;
   const std::vector<int> &other_price_;
   const std::vector<bool> &required_;
+  bool by_discount_;
 
   CourseComparator(const std::vector<int> &current_price,
                    const std::vector<int> &other_price,
-                   const std::vector<bool> &required) :
+                   const std::vector<bool> &required,
+                   bool by_discount) :
       current_price_(current_price),
       other_price_(other_price),
-      required_(required) {}
+      required_(required),
+      by_discount_(by_discount) {}
 
   bool operator () (int course_1, int course_2) const {
     // If one is required and the other is not required, the required one
@@ -28,6 +46,11 @@ struct CourseComparator {
       return required_[course_1];
     }
 
+    // The course cheaper in the current semester should come first.
+    if (!by_discount_) {
+      return current_price_[course_1] < current_price_[course_2];
+    }
+
     int discount_1 = other_price_[course_1] - current_price_[course_1];
     int discount_2 = other_price_[course_2] - current_price_[course_2];
 
@@ -99,29 +122,308 @@ void trace_prerequisites(int course_id,
   }
 }
 
+// FNV-1a, to tell checkpoints of different problems apart.
+void hash_value(int value, uint64_t *hash) {
+  for (int byte = 0; byte < 4; byte++) {
+    *hash ^= (static_cast<uint32_t>(value) >> (byte * 8)) & 0xff;
+    *hash *= 1099511628211ULL;
+  }
+}
+
+void hash_values(const std::vector<int> &values, uint64_t *hash) {
+  hash_value(static_cast<int>(values.size()), hash);
+  for (std::vector<int>::const_iterator value_itr = values.begin();
+       value_itr != values.end();
+       value_itr++) {
+    hash_value(*value_itr, hash);
+  }
 }
 
+uint64_t get_fingerprint(
+    const std::vector<std::vector<int> > &semester_prices,
+    const std::vector<int> &credits,
+    const std::vector<std::vector<int> > &prerequisites,
+    const std::vector<int> &interesting_courses,
+    const std::vector<int> &c_mins,
+    const std::vector<int> &c_maxs, int budget,
+    const SearchOptions &options) {
+  uint64_t hash = 14695981039346656037ULL;
+
+  hash_value(static_cast<int>(semester_prices.size()), &hash);
+  for (int type = 0; type < static_cast<int>(semester_prices.size());
+       type++) {
+    hash_values(semester_prices[type], &hash);
+  }
+
+  hash_values(credits, &hash);
+
+  for (int course_id = 0; course_id < static_cast<int>(prerequisites.size());
+       course_id++) {
+    hash_values(prerequisites[course_id], &hash);
+  }
+
+  hash_values(interesting_courses, &hash);
+  hash_values(c_mins, &hash);
+  hash_values(c_maxs, &hash);
+  hash_value(budget, &hash);
+
+  hash_value(static_cast<int>(options.seed), &hash);
+  hash_value(options.order_by_discount, &hash);
+  hash_value(options.strong_bound, &hash);
+  hash_value(options.next_semester_first, &hash);
+
+  return hash;
+}
+
+// Checks that there is at least one semester type, and that the prices,
+// credit limits and prerequisites agree on the number of types and courses.
+bool is_valid_problem(
+    const std::vector<std::vector<int> > &semester_prices,
+    const std::vector<int> &credits,
+    const std::vector<std::vector<int> > &prerequisites,
+    const std::vector<int> &interesting_courses,
+    const std::vector<int> &c_mins,
+    const std::vector<int> &c_maxs) {
+  int num_types = static_cast<int>(semester_prices.size());
+  int num_courses = static_cast<int>(credits.size());
+
+  if (num_types == 0
+      || static_cast<int>(c_mins.size()) != num_types
+      || static_cast<int>(c_maxs.size()) != num_types
+      || static_cast<int>(prerequisites.size()) != num_courses) {
+    return false;
+  }
+
+  for (int type = 0; type < num_types; type++) {
+    if (static_cast<int>(semester_prices[type].size()) != num_courses) {
+      return false;
+    }
+  }
+
+  for (int course_id = 0; course_id < num_courses; course_id++) {
+    for (std::vector<int>::const_iterator course_itr =
+         prerequisites[course_id].begin();
+         course_itr != prerequisites[course_id].end();
+         course_itr++) {
+      if (*course_itr < 0 || *course_itr >= num_courses) {
+        return false;
+      }
+    }
+  }
+
+  for (std::vector<int>::const_iterator course_itr =
+       interesting_courses.begin();
+       course_itr != interesting_courses.end();
+       course_itr++) {
+    if (*course_itr < 0 || *course_itr >= num_courses) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+// With kNumSemesterTypes known at compile time, the modulo is folded into
+// cheap arithmetic (a bit mask for the two-semester cycle).
+template <int kNumSemesterTypes>
+inline int semester_type_of(int semester, int num_types) {
+  return semester % (kNumSemesterTypes > 0 ? kNumSemesterTypes : num_types);
+}
+
+void sort_courses(const CourseComparator &comparator, unsigned int seed,
+                  std::vector<int> *order) {
+  int num_courses = static_cast<int>(order->size());
+  for (int index = 0; index < num_courses; index++) {
+    (*order)[index] = index;
+  }
+
+  if (seed == 0) {
+    std::sort(order->begin(), order->end(), comparator);
+    return;
+  }
+
+  // Shuffle first so that the stable sort breaks ties randomly.
+  std::mt19937 generator(seed);
+  std::shuffle(order->begin(), order->end(), generator);
+  std::stable_sort(order->begin(), order->end(), comparator);
+}
+
+// The first configuration is the default one, so a portfolio is never
+// slower than a single search by much more than the threading overhead.
+SearchOptions portfolio_options(int worker_id) {
+  SearchOptions options;
+
+  if (worker_id == 0) {
+    return options;
+  }
+
+  options.seed = static_cast<unsigned int>(worker_id);
+  options.order_by_discount = (worker_id % 2 == 0);
+  options.next_semester_first = (worker_id % 4 == 3);
+  options.strong_bound = (worker_id % 8 != 5);
+
+  return options;
+}
+
+}
+
+struct Scheduler::Incumbent {
+  Incumbent(int initial_price) :
+      best_price(initial_price), finished(false) {}
+
+  // -1 if no solution is found yet and the budget is unlimited.
+  std::atomic<int> best_price;
+
+  // Set by the first search that explores its whole search space.
+  std::atomic<bool> finished;
+
+  // Guards plan and the updates of best_price.
+  std::mutex mutex;
+  std::vector<std::vector<int> > plan;
+};
+
+Scheduler::Scheduler() :
+    incumbent_(NULL), telemetry_(NULL), profile_(NULL), num_states_(0),
+    num_bound_prunes_(0), num_infeasible_prunes_(0), depth_(0),
+    num_empty_semesters_(0), published_states_(0),
+    published_bound_prunes_(0), published_infeasible_prunes_(0),
+    next_poll_states_(INT64_MAX), state_limit_(-1), stopped_(false),
+    checkpoint_interval_seconds_(0),
+    checkpoint_fingerprint_(0), resume_index_(0) {
+}
+
+void Scheduler::publish_telemetry() {
+  telemetry_->add_progress(
+      num_states_ - published_states_,
+      num_bound_prunes_ - published_bound_prunes_,
+      num_infeasible_prunes_ - published_infeasible_prunes_);
+
+  published_states_ = num_states_;
+  published_bound_prunes_ = num_bound_prunes_;
+  published_infeasible_prunes_ = num_infeasible_prunes_;
+}
+
+void Scheduler::poll(const SemesterCycle &cycle, int current_semester,
+                     const std::vector<int> &semester_taken) {
+  if (telemetry_ != NULL) {
+    publish_telemetry();
+    telemetry_->set_position(depth_, current_semester);
+  }
+
+  // Stop every search through the incumbent. The node is not explored yet,
+  // so a later run resumes from it.
+  if (state_limit_ != -1 && num_states_ >= state_limit_) {
+    if (!checkpoint_file_.empty()) {
+      save_checkpoint(cycle, current_semester, semester_taken);
+    }
+
+    stopped_ = true;
+    incumbent_->finished.store(true, std::memory_order_relaxed);
+    next_poll_states_ = INT64_MAX;
+    return;
+  }
+
+  // Do not save while a resumed search is still following its path, as
+  // the checkpoint would be behind the one it resumed from.
+  if (!checkpoint_file_.empty()
+      && resume_index_ >= static_cast<int>(resume_path_.size())) {
+    std::chrono::steady_clock::time_point now =
+        std::chrono::steady_clock::now();
+
+    if (now - last_checkpoint_time_
+        >= std::chrono::seconds(checkpoint_interval_seconds_)) {
+      save_checkpoint(cycle, current_semester, semester_taken);
+      last_checkpoint_time_ = now;
+    }
+  }
+
+  next_poll_states_ = num_states_ + kPollInterval;
+}
+
+void Scheduler::save_checkpoint(const SemesterCycle &cycle,
+                                int current_semester,
+                                const std::vector<int> &semester_taken) {
+  SearchCheckpoint checkpoint;
+  checkpoint.fingerprint = checkpoint_fingerprint_;
+
+  {
+    std::lock_guard<std::mutex> lock(incumbent_->mutex);
+    checkpoint.best_price = incumbent_->best_price.load();
+    checkpoint.plan = incumbent_->plan;
+  }
+
+  // The courses of a semester are always taken in the consideration order,
+  // so the path follows from semester_taken.
+  int num_types = cycle.num_types();
+
+  for (int semester = 0; semester <= current_semester; semester++) {
+    const std::vector<int> &order = cycle.orders[semester % num_types];
+
+    for (std::vector<int>::const_iterator course_itr = order.begin();
+         course_itr != order.end();
+         course_itr++) {
+      if (semester_taken[*course_itr] == semester) {
+        checkpoint.path.push_back(*course_itr);
+      }
+    }
+
+    if (semester < current_semester) {
+      checkpoint.path.push_back(-1);
+    }
+  }
+
+  if (!checkpoint.write(checkpoint_file_.c_str())) {
+    printf("Failed to write the checkpoint to %s.\n",
+           checkpoint_file_.c_str());
+  }
+}
+
+void Scheduler::update_incumbent(
+    int cost, const std::vector<int> &semester_taken) {
+  int best_price = incumbent_->best_price.load(std::memory_order_relaxed);
+  if (best_price != -1 && cost >= best_price) {
+    return;
+  }
+
+  std::lock_guard<std::mutex> lock(incumbent_->mutex);
+
+  best_price = incumbent_->best_price.load(std::memory_order_relaxed);
+  if (best_price == -1 || cost < best_price) {
+    incumbent_->best_price.store(cost, std::memory_order_relaxed);
+    get_plan(semester_taken, &incumbent_->plan);
+
+    if (telemetry_ != NULL) {
+      telemetry_->set_incumbent_cost(cost);
+    }
+
+    /// DEBUG ///
+    printf("new_best_price = %d, num_states = %lld\n",
+           cost, static_cast<long long>(num_states_));
+  }
+}
+
+template <bool kProfiled, int kNumSemesterTypes>
 void Scheduler::explore_in_dfs(
     int candidate, int current_semester,
-    int candidate_id, int c_min, int c_max,
+    int candidate_id, int c_max,
     int last_semester_credits_so_far,
     int num_remaining_required, int cost_so_far,
+    const SemesterCycle &cycle,
     const std::vector<int> &current_prices,
-    const std::vector<int> &other_prices,
     const std::vector<int> &credits,
     const std::vector<int> &required_courses,
-    const std::vector<int> &current_order,
-    const std::vector<int> &other_order,
     const std::vector<std::vector<int> > &dependents,
     const std::vector<bool> &required,
     std::vector<int> *semester_taken,
     std::vector<int> *num_remaining_prerequisites,
-    std::vector<int> *last_semester_courses,
-    std::vector<std::vector<int> > *plan,
-    int *best_price) {
+    std::vector<int> *last_semester_courses) {
   if ((*semester_taken)[candidate] != -1
       || last_semester_credits_so_far + credits[candidate] > c_max
       || (*num_remaining_prerequisites)[candidate] > 0) {
+    num_infeasible_prunes_++;
+    if (kProfiled) {
+      profile_->record_infeasible(depth_);
+    }
     return;
   }
 
@@ -130,14 +432,20 @@ void Scheduler::explore_in_dfs(
 
   int delta_required = required[candidate]? 1 : 0;
 
-  depth_first_search(
-      current_prices, other_prices, credits, required_courses, dependents,
-      required, current_order, other_order, candidate_id, c_min, c_max,
+  if (kProfiled && depth_ == 0) {
+    profile_->begin_branch(candidate);
+  }
+
+  depth_++;
+
+  depth_first_search<kProfiled, kNumSemesterTypes>(
+      cycle, credits, required_courses, dependents, required, candidate_id,
       num_remaining_required - delta_required,
       cost_so_far + current_prices[candidate],
       last_semester_credits_so_far + credits[candidate], current_semester,
-      num_remaining_prerequisites, semester_taken, last_semester_courses,
-      best_price, plan);
+      num_remaining_prerequisites, semester_taken, last_semester_courses);
+
+  depth_--;
 
   revoke_selection(candidate, last_semester_courses, semester_taken);
 }
@@ -145,56 +453,81 @@ void Scheduler::explore_in_dfs(
 // Search rules:
 //   1. For each semester, arrange required courses first;
 //   2. Arrange courses cheaper in the current semester first
-//      (sort by the discount);
+//      (sort by the discount over the cheapest other semester type);
 //   3. In the current semester, if the minimum credit hours
 //      are already taken, the option moving on to the next
 //      semester comes before the option trying any non-required
 //      courses or courses more expensive in this semester.
+// SearchOptions may change the order of rule 2 and move the option of rule 3
+// before all the courses.
+template <bool kProfiled, int kNumSemesterTypes>
 void Scheduler::depth_first_search(
-    const std::vector<int> &current_prices,
-    const std::vector<int> &other_prices,
+    const SemesterCycle &cycle,
     const std::vector<int> &credits,
     const std::vector<int> &required_courses,
     const std::vector<std::vector<int> > &dependents,
     const std::vector<bool> &required,
-    const std::vector<int> &current_order,
-    const std::vector<int> &other_order,
     int last_selected,
-    int c_min, int c_max,
     int num_remaining_required,
     int cost_so_far, int last_semester_credits_so_far,
     int current_semester,
     std::vector<int> *num_remaining_prerequisites,
     std::vector<int> *semester_taken,
-    std::vector<int> *last_semester_courses,
-    int *best_price,
-    std::vector<std::vector<int> > *plan) {
+    std::vector<int> *last_semester_courses) {
+  // Another search of the portfolio has already found the optimum.
+  if (incumbent_->finished.load(std::memory_order_relaxed)) {
+    return;
+  }
+
+  if (num_states_ >= next_poll_states_) {
+    poll(cycle, current_semester, *semester_taken);
+  }
+
+  if (kProfiled) {
+    profile_->record_node(depth_, current_semester);
+  }
+
+  int num_types =
+      (kNumSemesterTypes > 0) ? kNumSemesterTypes : cycle.num_types();
+  int semester_type =
+      semester_type_of<kNumSemesterTypes>(current_semester, num_types);
+
+  const std::vector<int> &current_prices = cycle.prices[semester_type];
+  const std::vector<int> &other_prices = cycle.other_prices[semester_type];
+  const std::vector<int> &current_order = cycle.orders[semester_type];
+  int c_min = cycle.c_mins[semester_type];
+  int c_max = cycle.c_maxs[semester_type];
+
   // Check whether the DFS has arrived at a solution.
   if (num_remaining_required == 0 && last_semester_credits_so_far >= c_min) {
-    if (*best_price == -1 || cost_so_far < *best_price) {
-      *best_price = cost_so_far;
-      get_plan(*semester_taken, plan);
-
-      /// DEBUG ///
-      printf("new_best_price = %d, num_states = %d\n", *best_price, num_states_);
-    }
+    update_incumbent(cost_so_far, *semester_taken);
+    resume_index_ = static_cast<int>(resume_path_.size());
     return;
   }
 
   // Check whether it is possible to beat the current best price.
-  if (*best_price != -1) {
+  int best_price = incumbent_->best_price.load(std::memory_order_relaxed);
+  if (best_price != -1) {
     int minimum_cost = 0;
-    for (std::vector<int>::const_iterator course_itr =
-         required_courses.begin();
-         course_itr != required_courses.end();
-         course_itr++) {
-      if ((*semester_taken)[*course_itr] == -1) {
-        minimum_cost +=
-            std::min(current_prices[*course_itr], other_prices[*course_itr]);
+    if (options_.strong_bound) {
+      for (std::vector<int>::const_iterator course_itr =
+           required_courses.begin();
+           course_itr != required_courses.end();
+           course_itr++) {
+        if ((*semester_taken)[*course_itr] == -1) {
+          minimum_cost += cycle.cheapest_prices[*course_itr];
+        }
       }
     }
 
-    if (cost_so_far + minimum_cost >= *best_price) {
+    if (cost_so_far + minimum_cost >= best_price) {
+      num_bound_prunes_++;
+      if (kProfiled) {
+        profile_->record_bound_prune(depth_);
+      }
+
+      // The rest of a resumed path is under this node, so it is pruned too.
+      resume_index_ = static_cast<int>(resume_path_.size());
       return;
     }
   }
@@ -203,7 +536,26 @@ void Scheduler::depth_first_search(
   int num_courses = static_cast<int>(current_prices.size());
   int candidate_id = last_selected + 1;
 
-  for (; candidate_id < num_courses; candidate_id++) {
+  // A resumed search skips the branches explored before the checkpoint,
+  // which are those before the decision on its path.
+  int skip_until = -1;
+  bool resume_next_semester = false;
+
+  if (resume_index_ < static_cast<int>(resume_path_.size())) {
+    int decision = resume_path_[resume_index_++];
+
+    if (decision == -1) {
+      resume_next_semester = true;
+      skip_until = num_courses;
+    } else {
+      skip_until = static_cast<int>(
+          std::find(current_order.begin(), current_order.end(), decision)
+          - current_order.begin());
+    }
+  }
+
+  for (; !options_.next_semester_first && candidate_id < num_courses;
+       candidate_id++) {
     int candidate = current_order[candidate_id];
 
     if (!required[candidate]
@@ -211,19 +563,28 @@ void Scheduler::depth_first_search(
       break;
     }
 
+    if (candidate_id < skip_until) {
+      continue;
+    }
+
     num_states_++;
 
-    explore_in_dfs(
-        candidate, current_semester, candidate_id, c_min, c_max,
+    explore_in_dfs<kProfiled, kNumSemesterTypes>(
+        candidate, current_semester, candidate_id, c_max,
         last_semester_credits_so_far, num_remaining_required, cost_so_far,
-        current_prices, other_prices, credits, required_courses,
-        current_order, other_order, dependents, required, semester_taken,
-        num_remaining_prerequisites, last_semester_courses, plan, best_price);
+        cycle, current_prices, credits, required_courses, dependents,
+        required, semester_taken, num_remaining_prerequisites,
+        last_semester_courses);
   }
 
   // If the minimum credits requirement is already satisfied in the current
-  // semester, try to move on to the next semester.
-  if (last_semester_credits_so_far >= c_min) {
+  // semester, try to move on to the next semester. Skipping a whole cycle of
+  // semester types never helps, so that is not tried.
+  bool is_empty = last_semester_courses->empty();
+
+  if (last_semester_credits_so_far >= c_min
+      && (!is_empty || num_empty_semesters_ + 1 < num_types)
+      && (resume_next_semester || skip_until < candidate_id)) {
     for (std::vector<int>::iterator course_itr =
          last_semester_courses->begin();
          course_itr != last_semester_courses->end();
@@ -234,12 +595,21 @@ void Scheduler::depth_first_search(
 
     std::vector<int> empty_course_list;
 
-    depth_first_search(
-        other_prices, current_prices, credits, required_courses, dependents,
-        required, other_order, current_order, -1, c_min, c_max,
+    if (kProfiled && depth_ == 0) {
+      profile_->begin_branch(-1);
+    }
+
+    int saved_num_empty_semesters = num_empty_semesters_;
+    num_empty_semesters_ = is_empty ? num_empty_semesters_ + 1 : 0;
+    depth_++;
+
+    depth_first_search<kProfiled, kNumSemesterTypes>(
+        cycle, credits, required_courses, dependents, required, -1,
         num_remaining_required, cost_so_far, 0, current_semester + 1,
-        num_remaining_prerequisites, semester_taken, &empty_course_list,
-        best_price, plan);
+        num_remaining_prerequisites, semester_taken, &empty_course_list);
+
+    depth_--;
+    num_empty_semesters_ = saved_num_empty_semesters;
 
     for (std::vector<int>::iterator course_itr =
          last_semester_courses->begin();
@@ -250,6 +620,10 @@ void Scheduler::depth_first_search(
     }
   }
 
+  if (!resume_next_semester && candidate_id < skip_until) {
+    candidate_id = skip_until;
+  }
+
   // Try all the required but more expensive courses, followed by non-required
   // courses sorted by the discount.
   for (; candidate_id < num_courses; candidate_id++) {
@@ -257,44 +631,146 @@ void Scheduler::depth_first_search(
 
     num_states_++;
 
-    explore_in_dfs(
-        candidate, current_semester, candidate_id, c_min, c_max,
+    explore_in_dfs<kProfiled, kNumSemesterTypes>(
+        candidate, current_semester, candidate_id, c_max,
         last_semester_credits_so_far, num_remaining_required, cost_so_far,
-        current_prices, other_prices, credits, required_courses,
-        current_order, other_order, dependents, required, semester_taken,
-        num_remaining_prerequisites, last_semester_courses, plan, best_price);
+        cycle, current_prices, credits, required_courses, dependents,
+        required, semester_taken, num_remaining_prerequisites,
+        last_semester_courses);
   }
 }
 
-int Scheduler::minimum_cost(
-    const std::vector<int> &fall_prices,
-    const std::vector<int> &spring_prices,
+void Scheduler::search(
+    const SemesterCycle &shared_cycle,
+    const std::vector<int> &credits,
+    const std::vector<int> &required_courses,
+    const std::vector<std::vector<int> > &dependents,
+    const std::vector<bool> &required,
+    const std::vector<int> &num_prerequisites) {
+  int num_courses = static_cast<int>(credits.size());
+  int num_required = static_cast<int>(required_courses.size());
+
+  // Get the consideration order in each semester type.
+  SemesterCycle cycle(shared_cycle);
+  cycle.orders.resize(cycle.num_types());
+
+  for (int type = 0; type < cycle.num_types(); type++) {
+    cycle.orders[type].resize(num_courses);
+    sort_courses(CourseComparator(cycle.prices[type],
+                                  cycle.other_prices[type], required,
+                                  options_.order_by_discount),
+                 options_.seed, &cycle.orders[type]);
+  }
+
+  // semester_taken records the semester taken for each courses.
+  std::vector<int> semester_taken(num_courses);
+  std::fill(semester_taken.begin(), semester_taken.end(), -1);
+
+  // last_semester_courses records the courses for the current semester.
+  std::vector<int> last_semester_courses;
+
+  std::vector<int> num_remaining_prerequisites(num_prerequisites);
+
+  num_states_ = 1;
+  num_bound_prunes_ = 0;
+  num_infeasible_prunes_ = 0;
+  depth_ = 0;
+  num_empty_semesters_ = 0;
+
+  published_states_ = 0;
+  published_bound_prunes_ = 0;
+  published_infeasible_prunes_ = 0;
+
+  resume_index_ = 0;
+  last_checkpoint_time_ = std::chrono::steady_clock::now();
+
+  stopped_ = false;
+
+  next_poll_states_ =
+      (telemetry_ != NULL || !checkpoint_file_.empty() || state_limit_ != -1)
+      ? 0 : INT64_MAX;
+
+  // The usual Fall/Spring cycle gets its own instantiation.
+  if (cycle.num_types() == 2) {
+    if (profile_ != NULL) {
+      depth_first_search<true, 2>(
+          cycle, credits, required_courses, dependents, required, -1,
+          num_required, 0, 0, 0, &num_remaining_prerequisites,
+          &semester_taken, &last_semester_courses);
+    } else {
+      depth_first_search<false, 2>(
+          cycle, credits, required_courses, dependents, required, -1,
+          num_required, 0, 0, 0, &num_remaining_prerequisites,
+          &semester_taken, &last_semester_courses);
+    }
+  } else {
+    if (profile_ != NULL) {
+      depth_first_search<true, 0>(
+          cycle, credits, required_courses, dependents, required, -1,
+          num_required, 0, 0, 0, &num_remaining_prerequisites,
+          &semester_taken, &last_semester_courses);
+    } else {
+      depth_first_search<false, 0>(
+          cycle, credits, required_courses, dependents, required, -1,
+          num_required, 0, 0, 0, &num_remaining_prerequisites,
+          &semester_taken, &last_semester_courses);
+    }
+  }
+
+  // Only the counters are flushed, so the position stays where the search
+  // last reported it.
+  if (telemetry_ != NULL) {
+    publish_telemetry();
+  }
+
+  // Either the whole search space is explored or another search has
+  // already done so, so the incumbent is optimal.
+  incumbent_->finished.store(true, std::memory_order_relaxed);
+}
+
+int Scheduler::run_searches(
+    const std::vector<std::vector<int> > &semester_prices,
     const std::vector<int> &credits,
     const std::vector<std::vector<int> > &prerequisites,
     const std::vector<int> &interesting_courses,
-    int c_min, int c_max, int budget,
+    const std::vector<int> &c_mins,
+    const std::vector<int> &c_maxs, int budget,
+    const std::vector<SearchOptions> &configurations,
     std::vector<std::vector<int> > *plan) {
-  int num_courses = static_cast<int>(fall_prices.size());
+  plan->clear();
+  stopped_ = false;
+
+  if (!is_valid_problem(semester_prices, credits, prerequisites,
+                        interesting_courses, c_mins, c_maxs)) {
+    printf("Invalid problem: the semester types, credit limits or "
+           "courses do not match.\n");
+    return -1;
+  }
+
+  int num_courses = static_cast<int>(credits.size());
+  int num_types = static_cast<int>(semester_prices.size());
 
   printf("num_courses = %d\n\n", num_courses);
 
   for (int course_id = 0; course_id < num_courses; course_id++) {
-    printf("Course %d: %d, %d, %d\n",
-           course_id, fall_prices[course_id], spring_prices[course_id],
-           credits[course_id]);
+    printf("Course %d:", course_id);
+    for (int type = 0; type < num_types; type++) {
+      printf(" %d,", semester_prices[type][course_id]);
+    }
+    printf(" %d\n", credits[course_id]);
   }
   printf("\n");
 
   std::vector<std::vector<int> > dependents(num_courses);
-  std::vector<int> num_remaining_prerequisites(num_courses);
+  std::vector<int> num_prerequisites(num_courses);
 
-  // Construct dependents and num_remaining_prerequisites.
+  // Construct dependents and num_prerequisites.
   for (int course_id = 0; course_id < num_courses; course_id++) {
-    int num_prerequisites = static_cast<int>(prerequisites[course_id].size());
-
-    num_remaining_prerequisites[course_id] = num_prerequisites;
+    num_prerequisites[course_id] =
+        static_cast<int>(prerequisites[course_id].size());
 
-    for (int prerequisite_id = 0; prerequisite_id < num_prerequisites;
+    for (int prerequisite_id = 0;
+         prerequisite_id < num_prerequisites[course_id];
          prerequisite_id++) {
       int curr_prerequisite = prerequisites[course_id][prerequisite_id];
       dependents[curr_prerequisite].push_back(course_id);
@@ -342,62 +818,248 @@ int Scheduler::minimum_cost(
   }
   printf("\n\n");
 
-  int num_required = static_cast<int>(required_courses.size());
+  // Construct the per-type prices. With a single semester type, the
+  // "other" semester is the same one.
+  SemesterCycle cycle;
+  cycle.prices = semester_prices;
+  cycle.c_mins = c_mins;
+  cycle.c_maxs = c_maxs;
+  cycle.other_prices.resize(num_types);
+  cycle.cheapest_prices.resize(num_courses);
 
-  // Get the consideration order in Fall and Spring semesters.
-  std::vector<int> fall_order(num_courses), spring_order(num_courses);
-  for (int index = 0; index < num_courses; index++) {
-    fall_order[index] = spring_order[index] = index;
+  for (int course_id = 0; course_id < num_courses; course_id++) {
+    cycle.cheapest_prices[course_id] = semester_prices[0][course_id];
+    for (int type = 1; type < num_types; type++) {
+      cycle.cheapest_prices[course_id] = std::min(
+          cycle.cheapest_prices[course_id], semester_prices[type][course_id]);
+    }
   }
 
-  std::sort(fall_order.begin(), fall_order.end(),
-            CourseComparator(fall_prices, spring_prices, required));
-  std::sort(spring_order.begin(), spring_order.end(),
-            CourseComparator(spring_prices, fall_prices, required));
+  for (int type = 0; type < num_types; type++) {
+    cycle.other_prices[type].resize(num_courses);
+
+    for (int course_id = 0; course_id < num_courses; course_id++) {
+      int other_price = (num_types == 1) ? semester_prices[type][course_id]
+                                         : INT_MAX;
+      for (int other_type = 0; other_type < num_types; other_type++) {
+        if (other_type != type) {
+          other_price =
+              std::min(other_price, semester_prices[other_type][course_id]);
+        }
+      }
 
-  printf("fall_order:");
-  for (std::vector<int>::const_iterator course_itr = fall_order.begin();
-       course_itr != fall_order.end();
-       course_itr++) {
-    printf(" %d", *course_itr);
+      cycle.other_prices[type][course_id] = other_price;
+    }
   }
-  printf("\n");
-  printf("spring_order:");
-  for (std::vector<int>::const_iterator course_itr = spring_order.begin();
-       course_itr != spring_order.end();
-       course_itr++) {
-    printf(" %d", *course_itr);
+
+  if (telemetry_ != NULL) {
+    // No plan can be cheaper than taking every required course at its
+    // cheapest price.
+    int root_lower_bound = 0;
+    for (std::vector<int>::const_iterator course_itr =
+         required_courses.begin();
+         course_itr != required_courses.end();
+         course_itr++) {
+      root_lower_bound += cycle.cheapest_prices[*course_itr];
+    }
+
+    telemetry_->start(root_lower_bound);
   }
-  printf("\n\n");
 
-  // semester_taken records the semester taken for each courses.
-  std::vector<int> semester_taken(num_courses);
-  std::fill(semester_taken.begin(), semester_taken.end(), -1);
+  Incumbent incumbent((budget == -1) ? -1 : budget + 1);
 
-  // last_semester_courses records the courses for the current semester.
-  std::vector<int> last_semester_courses;
+  int num_workers = static_cast<int>(configurations.size());
+  std::vector<Scheduler> workers(num_workers);
 
-  int best_price = (budget == -1) ? -1 : budget + 1;
+  for (int worker_id = 0; worker_id < num_workers; worker_id++) {
+    workers[worker_id].options_ = configurations[worker_id];
+    workers[worker_id].incumbent_ = &incumbent;
+    workers[worker_id].telemetry_ = telemetry_;
+    workers[worker_id].state_limit_ = state_limit_;
+  }
 
-  num_states_ = 1;
+  if (profile_ != NULL) {
+    profile_->clear();
+    workers[0].profile_ = profile_;
+  }
+
+  // Only a single search is checkpointed.
+  bool checkpointed = !checkpoint_file_.empty() && num_workers == 1;
+
+  if (checkpointed) {
+    workers[0].checkpoint_file_ = checkpoint_file_;
+    workers[0].checkpoint_interval_seconds_ = checkpoint_interval_seconds_;
+    workers[0].checkpoint_fingerprint_ = get_fingerprint(
+        semester_prices, credits, prerequisites, interesting_courses,
+        c_mins, c_maxs, budget, configurations[0]);
+
+    SearchCheckpoint checkpoint;
+    bool valid = checkpoint.read(checkpoint_file_.c_str())
+                 && checkpoint.fingerprint
+                    == workers[0].checkpoint_fingerprint_;
+
+    for (std::vector<int>::const_iterator decision_itr =
+         checkpoint.path.begin();
+         valid && decision_itr != checkpoint.path.end();
+         decision_itr++) {
+      valid = *decision_itr >= -1 && *decision_itr < num_courses;
+    }
+
+    for (int semester = 0;
+         valid && semester < static_cast<int>(checkpoint.plan.size());
+         semester++) {
+      for (std::vector<int>::const_iterator course_itr =
+           checkpoint.plan[semester].begin();
+           valid && course_itr != checkpoint.plan[semester].end();
+           course_itr++) {
+        valid = *course_itr >= 0 && *course_itr < num_courses;
+      }
+    }
+
+    if (valid) {
+      printf("Resuming from %s at depth %d.\n", checkpoint_file_.c_str(),
+             static_cast<int>(checkpoint.path.size()));
+
+      int best_price = incumbent.best_price.load();
+      if (checkpoint.best_price != -1
+          && (best_price == -1 || checkpoint.best_price < best_price)) {
+        incumbent.best_price.store(checkpoint.best_price);
+        incumbent.plan = checkpoint.plan;
+
+        if (telemetry_ != NULL) {
+          telemetry_->set_incumbent_cost(checkpoint.best_price);
+        }
+      }
+
+      workers[0].resume_path_ = checkpoint.path;
+    }
+  }
+
+  if (num_workers == 1) {
+    workers[0].search(cycle, credits, required_courses, dependents, required,
+                      num_prerequisites);
+  } else {
+    std::vector<std::thread> threads;
+
+    for (int worker_id = 0; worker_id < num_workers; worker_id++) {
+      threads.push_back(std::thread(
+          &Scheduler::search, &workers[worker_id],
+          std::cref(cycle), std::cref(credits), std::cref(required_courses),
+          std::cref(dependents), std::cref(required),
+          std::cref(num_prerequisites)));
+    }
 
-  depth_first_search(fall_prices, spring_prices,
-                     credits, required_courses,
-                     dependents, required,
-                     fall_order, spring_order, -1,
-                     c_min, c_max,
-                     num_required, 0, 0, 0,
-                     &num_remaining_prerequisites,
-                     &semester_taken,
-                     &last_semester_courses,
-                     &best_price, plan);
- 
-  printf("overall_num_states = %d\n", num_states_);
+    for (int worker_id = 0; worker_id < num_workers; worker_id++) {
+      threads[worker_id].join();
+      printf("worker %d: num_states = %lld\n", worker_id,
+             static_cast<long long>(workers[worker_id].num_states_));
+    }
+  }
+
+  num_states_ = 0;
+  for (int worker_id = 0; worker_id < num_workers; worker_id++) {
+    num_states_ += workers[worker_id].num_states_;
+    stopped_ = stopped_ || workers[worker_id].stopped_;
+  }
+
+  printf("overall_num_states = %lld\n",
+         static_cast<long long>(num_states_));
+
+  if (telemetry_ != NULL) {
+    if (stopped_) {
+      telemetry_->stop();
+    } else {
+      telemetry_->finish();
+    }
+  }
+
+  // There is nothing left to resume unless the search was stopped.
+  if (checkpointed && !workers[0].stopped_) {
+    remove(checkpoint_file_.c_str());
+  }
+
+  int best_price = incumbent.best_price.load();
+  *plan = incumbent.plan;
 
   if (budget != -1 && best_price == budget + 1) {
     best_price = -1;
   }
- 
+
   return best_price;
 }
 
+int Scheduler::minimum_cost(
+    const std::vector<int> &fall_prices,
+    const std::vector<int> &spring_prices,
+    const std::vector<int> &credits,
+    const std::vector<std::vector<int> > &prerequisites,
+    const std::vector<int> &interesting_courses,
+    int c_min, int c_max, int budget,
+    std::vector<std::vector<int> > *plan) {
+  std::vector<std::vector<int> > semester_prices(2);
+  semester_prices[0] = fall_prices;
+  semester_prices[1] = spring_prices;
+
+  return minimum_cost(semester_prices, credits, prerequisites,
+                      interesting_courses, std::vector<int>(2, c_min),
+                      std::vector<int>(2, c_max), budget, plan);
+}
+
+int Scheduler::minimum_cost(
+    const std::vector<std::vector<int> > &semester_prices,
+    const std::vector<int> &credits,
+    const std::vector<std::vector<int> > &prerequisites,
+    const std::vector<int> &interesting_courses,
+    const std::vector<int> &c_mins,
+    const std::vector<int> &c_maxs, int budget,
+    std::vector<std::vector<int> > *plan) {
+  std::vector<SearchOptions> configurations(1, options_);
+
+  return run_searches(semester_prices, credits, prerequisites,
+                      interesting_courses, c_mins, c_maxs, budget,
+                      configurations, plan);
+}
+
+int Scheduler::portfolio_minimum_cost(
+    const std::vector<int> &fall_prices,
+    const std::vector<int> &spring_prices,
+    const std::vector<int> &credits,
+    const std::vector<std::vector<int> > &prerequisites,
+    const std::vector<int> &interesting_courses,
+    int c_min, int c_max, int budget, int num_threads,
+    std::vector<std::vector<int> > *plan) {
+  std::vector<std::vector<int> > semester_prices(2);
+  semester_prices[0] = fall_prices;
+  semester_prices[1] = spring_prices;
+
+  return portfolio_minimum_cost(
+      semester_prices, credits, prerequisites, interesting_courses,
+      std::vector<int>(2, c_min), std::vector<int>(2, c_max), budget,
+      num_threads, plan);
+}
+
+int Scheduler::portfolio_minimum_cost(
+    const std::vector<std::vector<int> > &semester_prices,
+    const std::vector<int> &credits,
+    const std::vector<std::vector<int> > &prerequisites,
+    const std::vector<int> &interesting_courses,
+    const std::vector<int> &c_mins,
+    const std::vector<int> &c_maxs, int budget, int num_threads,
+    std::vector<std::vector<int> > *plan) {
+  if (num_threads <= 0) {
+    num_threads = static_cast<int>(std::thread::hardware_concurrency());
+  }
+
+  if (num_threads <= 0) {
+    num_threads = 1;
+  }
+
+  std::vector<SearchOptions> configurations;
+  for (int worker_id = 0; worker_id < num_threads; worker_id++) {
+    configurations.push_back(portfolio_options(worker_id));
+  }
+
+  return run_searches(semester_prices, credits, prerequisites,
+                      interesting_courses, c_mins, c_maxs, budget,
+                      configurations, plan);
+}
@@ -3,10 +3,86 @@
 #ifndef SCHEDULER_H_
 #define SCHEDULER_H_
 
+#include <stdint.h>
+
+#include <chrono>
+#include <string>
 #include <vector>
 
+class SearchProfile;
+class SolverTelemetry;
+
+// Knobs which change the order the search space is explored in.
+// Any combination finds the same minimum cost, but the running time on a
+// given instance can differ a lot between them.
+struct SearchOptions {
+  SearchOptions() :
+      seed(0), order_by_discount(true), strong_bound(true),
+      next_semester_first(false) {}
+
+  // If seed equals 0, ties in the course order are broken by course id.
+  // Otherwise they are broken by a random permutation drawn from the seed.
+  unsigned int seed;
+
+  // Sort the courses by the discount in the current semester if true,
+  // otherwise by the price in the current semester.
+  bool order_by_discount;
+
+  // Bound by the cheapest prices of the remaining required courses if true,
+  // otherwise only by the cost so far.
+  bool strong_bound;
+
+  // Try moving on to the next semester before any course of the current
+  // semester once the minimum credits are taken.
+  bool next_semester_first;
+};
+
 class Scheduler {
  public:
+  Scheduler();
+
+  void set_options(const SearchOptions &options) {
+    options_ = options;
+  }
+
+  // Publishes the progress of the following solves to telemetry, which
+  // should already be created. NULL turns the publishing off.
+  void set_telemetry(SolverTelemetry *telemetry) {
+    telemetry_ = telemetry;
+  }
+
+  // Records the shape of the search tree of the following solves into
+  // profile, which is cleared first. In portfolio mode only the first
+  // search is profiled, and it stops as soon as another search finishes,
+  // so its profile may cover only part of its tree. NULL turns the
+  // profiling off.
+  void set_profile(SearchProfile *profile) {
+    profile_ = profile;
+  }
+
+  // Saves the state of the following solves to file_name, at most once
+  // every interval_seconds. A solve resumes from file_name if it holds a
+  // checkpoint of the same problem and options, and removes it when done.
+  // Portfolio solves are not checkpointed. NULL turns the checkpoints off.
+  void set_checkpoint(const char *file_name, int interval_seconds) {
+    checkpoint_file_ = (file_name != NULL) ? file_name : "";
+    checkpoint_interval_seconds_ = interval_seconds;
+  }
+
+  // Stops the following solves after about max_states states, saving a
+  // checkpoint to resume from if checkpoints are on. A stopped solve
+  // returns the best price found so far, which may not be the minimum.
+  // -1 means no limit.
+  void set_state_limit(int64_t max_states) {
+    state_limit_ = max_states;
+  }
+
+  // Whether the last solve stopped at the state limit, in which case its
+  // price is not proven to be the minimum.
+  bool stopped() const {
+    return stopped_;
+  }
+
   // Courses are numbered from 0.
   // If budget equals -1, it means the budget is unlimited.
   int minimum_cost(const std::vector<int> &fall_prices,
@@ -17,47 +93,167 @@ class Scheduler {
                    int c_min, int c_max, int budget,
                    std::vector<std::vector<int> > *plan);
 
+  // Same as above, but semesters cycle through semester_prices.size()
+  // semester types, starting from type 0. semester_prices[type][course] is
+  // the price of the course in a semester of that type, and c_mins[type]
+  // and c_maxs[type] are its credit limits.
+  // Returns -1 with an empty plan if there is no semester type, or if the
+  // sizes of the arguments do not agree.
+  int minimum_cost(const std::vector<std::vector<int> > &semester_prices,
+                   const std::vector<int> &credits,
+                   const std::vector<std::vector<int> > &prerequisites,
+                   const std::vector<int> &interesting_courses,
+                   const std::vector<int> &c_mins,
+                   const std::vector<int> &c_maxs, int budget,
+                   std::vector<std::vector<int> > *plan);
+
+  // Same as minimum_cost, but runs num_threads differently configured
+  // searches in parallel. They share the best price found so far, and the
+  // first search to finish stops the others.
+  // If num_threads is not positive, one thread per core is used.
+  int portfolio_minimum_cost(
+      const std::vector<int> &fall_prices,
+      const std::vector<int> &spring_prices,
+      const std::vector<int> &credits,
+      const std::vector<std::vector<int> > &prerequisites,
+      const std::vector<int> &interesting_courses,
+      int c_min, int c_max, int budget, int num_threads,
+      std::vector<std::vector<int> > *plan);
+
+  int portfolio_minimum_cost(
+      const std::vector<std::vector<int> > &semester_prices,
+      const std::vector<int> &credits,
+      const std::vector<std::vector<int> > &prerequisites,
+      const std::vector<int> &interesting_courses,
+      const std::vector<int> &c_mins,
+      const std::vector<int> &c_maxs, int budget, int num_threads,
+      std::vector<std::vector<int> > *plan);
+
  private:
+  struct Incumbent;
+
+  // Everything which depends on the semester type, indexed by the type.
+  struct SemesterCycle {
+    int num_types() const {
+      return static_cast<int>(prices.size());
+    }
+
+    std::vector<std::vector<int> > prices;
+
+    // The cheapest price of each course in the other semester types.
+    std::vector<std::vector<int> > other_prices;
+
+    // The consideration order of the courses.
+    std::vector<std::vector<int> > orders;
+
+    std::vector<int> c_mins;
+    std::vector<int> c_maxs;
+
+    // The cheapest price of each course in any semester type.
+    std::vector<int> cheapest_prices;
+  };
+
+  int run_searches(const std::vector<std::vector<int> > &semester_prices,
+                   const std::vector<int> &credits,
+                   const std::vector<std::vector<int> > &prerequisites,
+                   const std::vector<int> &interesting_courses,
+                   const std::vector<int> &c_mins,
+                   const std::vector<int> &c_maxs, int budget,
+                   const std::vector<SearchOptions> &configurations,
+                   std::vector<std::vector<int> > *plan);
+
+  void search(const SemesterCycle &cycle,
+              const std::vector<int> &credits,
+              const std::vector<int> &required_courses,
+              const std::vector<std::vector<int> > &dependents,
+              const std::vector<bool> &required,
+              const std::vector<int> &num_prerequisites);
+
+  void update_incumbent(int cost, const std::vector<int> &semester_taken);
+
+  // Adds the counters not yet published to telemetry_.
+  void publish_telemetry();
+
+  // Called every kPollInterval states to publish telemetry and to save
+  // checkpoints.
+  void poll(const SemesterCycle &cycle, int current_semester,
+            const std::vector<int> &semester_taken);
+
+  void save_checkpoint(const SemesterCycle &cycle, int current_semester,
+                       const std::vector<int> &semester_taken);
+
+  // If kProfiled is false, the search does not touch profile_, so the
+  // profiling costs nothing when it is off.
+  // kNumSemesterTypes is the number of semester types if known at compile
+  // time, or 0 if it is only known from the cycle.
+  template <bool kProfiled, int kNumSemesterTypes>
   void explore_in_dfs(
     int candidate, int current_semester,
-    int candidate_id, int c_min, int c_max,
+    int candidate_id, int c_max,
     int last_semester_credits_so_far,
     int num_remaining_required, int cost_so_far,
+    const SemesterCycle &cycle,
     const std::vector<int> &current_prices,
-    const std::vector<int> &other_prices,
     const std::vector<int> &credits,
     const std::vector<int> &required_courses,
-    const std::vector<int> &current_order,
-    const std::vector<int> &other_order,
     const std::vector<std::vector<int> > &dependents,
     const std::vector<bool> &required,
     std::vector<int> *semester_taken,
     std::vector<int> *num_remaining_prerequisites,
-    std::vector<int> *last_semester_courses,
-    std::vector<std::vector<int> > *plan,
-    int *best_price);
+    std::vector<int> *last_semester_courses);
 
+  template <bool kProfiled, int kNumSemesterTypes>
   void depth_first_search(
-    const std::vector<int> &current_prices,
-    const std::vector<int> &other_prices,
+    const SemesterCycle &cycle,
     const std::vector<int> &credits,
     const std::vector<int> &required_courses,
     const std::vector<std::vector<int> > &dependents,
     const std::vector<bool> &required,
-    const std::vector<int> &current_order,
-    const std::vector<int> &other_order,
     int last_selected,
-    int c_min, int c_max,
     int num_remaining_required,
     int cost_so_far, int last_semester_credits_so_far,
     int current_semester,
     std::vector<int> *num_remaining_prerequisites,
     std::vector<int> *semester_taken,
-    std::vector<int> *last_semester_courses,
-    int *best_price,
-    std::vector<std::vector<int> > *plan);
+    std::vector<int> *last_semester_courses);
+
+  SearchOptions options_;
+  Incumbent *incumbent_;
+  SolverTelemetry *telemetry_;
+  SearchProfile *profile_;
+
+  int64_t num_states_;
+  int64_t num_bound_prunes_;
+  int64_t num_infeasible_prunes_;
+
+  // The number of decisions (courses or semester transitions) on the
+  // current DFS path.
+  int depth_;
+
+  // The number of empty semesters right before the current one.
+  int num_empty_semesters_;
+
+  // The counters already added to telemetry_.
+  int64_t published_states_;
+  int64_t published_bound_prunes_;
+  int64_t published_infeasible_prunes_;
+
+  // When to call poll again.
+  int64_t next_poll_states_;
+
+  int64_t state_limit_;
+
+  // Whether the last search or solve stopped at state_limit_.
+  bool stopped_;
+
+  std::string checkpoint_file_;
+  int checkpoint_interval_seconds_;
+  uint64_t checkpoint_fingerprint_;
+  std::chrono::steady_clock::time_point last_checkpoint_time_;
 
-  int num_states_;
+  // The path of a resumed search, and how much of it is already followed.
+  std::vector<int> resume_path_;
+  int resume_index_;
 };
 
 #endif  // SCHEDULER_H_
@@ -1,9 +1,21 @@
 // Author: Mingcheng Chen (linyufly@gmail.com)
 
 #include "scheduler.h"
+#include "search_checkpoint.h"
+#include "search_profile.h"
+#include "solver_telemetry.h"
+
+#include <stdint.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 #include <cstdio>
+#include <cstring>
 
+#include <algorithm>
+#include <atomic>
+#include <random>
+#include <thread>
 #include <vector>
 
 // const char *kInputFile = "data/smallScenario.txt";
@@ -17,25 +29,79 @@ const char *kInputFile = "firstScenario.txt";
 // const char *kInputFile = "fourthScenario.txt";
 // const char *kInputFile = "input.txt";
 
-void minimum_cost_test() {
-  printf("minimum_cost_test {\n");
+// Attach TelemetryMonitor to this segment to watch the solves.
+const char *kTelemetryName = "/course_scheduler";
+
+// A little longer than the rate window of SolverTelemetry.
+const int kRateWindowMicroseconds = 600000;
+
+const char *kProfileFile = "search_profile.json";
+
+const char *kCheckpointFile = "scheduler.checkpoint";
+
+// checkpoint_resume_test stops each run after kResumeStateLimit states, and
+// fails if the problem is not solved within kMaxResumeRuns runs.
+const unsigned int kResumeSeed = 2;
+const int64_t kResumeStateLimit = 1 << 20;
+const int kMaxResumeRuns = 100;
 
-  FILE *fin = fopen(kInputFile, "r");
+// corrupt_checkpoint_test stops a solve of a generated problem after
+// kCorruptStateLimit states to get a checkpoint to corrupt.
+const unsigned int kCorruptSeed = 8;
+const int64_t kCorruptStateLimit = 1 << 16;
+
+// checkpoint_progress_test solves a hard problem past 2^31 states and
+// checks that the checkpoint file keeps being rewritten. It takes several
+// minutes, so it only runs with --long.
+const unsigned int kProgressSeed = 0;
+const int kProgressNumCourses = 48;
+const int kProgressNumInterestingCourses = 12;
+const int64_t kProgressStateLimit = 5LL << 29;
+const int kProgressCheckpointInterval = 1;
+const int kProgressMaxGap = 5;
+
+// If kNumThreads is not positive, one thread per core is used.
+const int kNumThreads = 0;
+
+// The tests on generated problems use seeds 1 to kNumGeneratedSeeds.
+const unsigned int kNumGeneratedSeeds = 8;
+
+struct Problem {
+  std::vector<int> fall_prices, spring_prices, credits;
+  std::vector<std::vector<int> > prerequisites;
+  std::vector<int> interesting_courses;
+  int c_min, c_max, budget;
+};
+
+// Returns false if the file is missing or has no header.
+bool read_problem(const char *file_name, Problem *problem) {
+  FILE *fin = fopen(file_name, "r");
+  if (fin == NULL) {
+    printf("Failed to open %s.\n", file_name);
+    return false;
+  }
 
-  int num_courses, c_min, c_max;
-  fscanf(fin, "%d %d %d", &num_courses, &c_min, &c_max);
+  int num_courses;
+  if (fscanf(fin, "%d %d %d",
+             &num_courses, &problem->c_min, &problem->c_max) != 3
+      || num_courses < 0) {
+    printf("Failed to read the header of %s.\n", file_name);
+    fclose(fin);
+    return false;
+  }
 
-  std::vector<int> fall_prices(num_courses);
-  std::vector<int> spring_prices(num_courses);
-  std::vector<int> credits(num_courses);
+  problem->fall_prices.resize(num_courses);
+  problem->spring_prices.resize(num_courses);
+  problem->credits.resize(num_courses);
 
   for (int course_id = 0; course_id < num_courses; course_id++) {
-    fscanf(fin, "%d %d %d", &fall_prices[course_id],
-                            &spring_prices[course_id],
-                            &credits[course_id]);
+    fscanf(fin, "%d %d %d", &problem->fall_prices[course_id],
+                            &problem->spring_prices[course_id],
+                            &problem->credits[course_id]);
   }
 
-  std::vector<std::vector<int> > prerequisites(num_courses);
+  problem->prerequisites.clear();
+  problem->prerequisites.resize(num_courses);
 
   for (int course_id = 0; course_id < num_courses; course_id++) {
     int num_prerequisites;
@@ -43,42 +109,90 @@ void minimum_cost_test() {
     for (int count = 0; count < num_prerequisites; count++) {
       int prerequisite;
       fscanf(fin, "%d", &prerequisite);
-      prerequisites[course_id].push_back(prerequisite - 1);
+      problem->prerequisites[course_id].push_back(prerequisite - 1);
     }
   }
 
-  std::vector<int> interesting_courses;
   int num_interesting_courses;
   fscanf(fin, "%d", &num_interesting_courses);
-  interesting_courses.resize(num_interesting_courses);
+  problem->interesting_courses.resize(num_interesting_courses);
 
   for (int count = 0; count < num_interesting_courses; count++) {
-    fscanf(fin, "%d", &interesting_courses[count]);
-    interesting_courses[count]--;
+    fscanf(fin, "%d", &problem->interesting_courses[count]);
+    problem->interesting_courses[count]--;
   }
 
-  int budget;
-
-  fscanf(fin, "%d", &budget);
+  fscanf(fin, "%d", &problem->budget);
 
   fclose(fin);
 
   printf("Finished reading the data.\n");
 
-  std::vector<std::vector<int> > plan;
+  return true;
+}
 
-  Scheduler scheduler;
-  int best_price = scheduler.minimum_cost(
-      fall_prices, spring_prices, credits, prerequisites,
-      interesting_courses, c_min, c_max, budget, &plan);
+// Generates a random problem from a fixed seed, so that the tests do not
+// depend on an input file.
+void generate_problem(unsigned int seed, int num_courses,
+                      int num_interesting_courses, Problem *problem) {
+  std::mt19937 generator(seed);
+  std::uniform_int_distribution<int> price_distribution(1, 1000);
+  std::uniform_int_distribution<int> credit_distribution(1, 6);
+  std::uniform_real_distribution<double> rate_distribution(0.0, 1.0);
+
+  problem->c_min = 8;
+  problem->c_max = 16;
+  problem->budget = -1;
+
+  problem->fall_prices.resize(num_courses);
+  problem->spring_prices.resize(num_courses);
+  problem->credits.resize(num_courses);
+
+  for (int course_id = 0; course_id < num_courses; course_id++) {
+    problem->fall_prices[course_id] = price_distribution(generator);
+    problem->spring_prices[course_id] = price_distribution(generator);
+    problem->credits[course_id] = credit_distribution(generator);
+  }
+
+  // Prerequisites only point to courses earlier in a random order, so
+  // there is no cycle.
+  std::vector<int> courses(num_courses);
+  for (int index = 0; index < num_courses; index++) {
+    courses[index] = index;
+  }
+  std::shuffle(courses.begin(), courses.end(), generator);
 
+  problem->prerequisites.clear();
+  problem->prerequisites.resize(num_courses);
+
+  for (int curr_index = 1; curr_index < num_courses; curr_index++) {
+    for (int prev_index = 0; prev_index < curr_index; prev_index++) {
+      if (rate_distribution(generator) < 0.12) {
+        problem->prerequisites[courses[curr_index]].push_back(
+            courses[prev_index]);
+      }
+    }
+  }
+
+  std::shuffle(courses.begin(), courses.end(), generator);
+  problem->interesting_courses.assign(
+      courses.begin(), courses.begin() + num_interesting_courses);
+}
+
+bool file_exists(const char *file_name) {
+  struct stat file_stat;
+  return stat(file_name, &file_stat) == 0;
+}
+
+void print_plan(const std::vector<std::vector<int> > &semester_prices,
+                int best_price, const std::vector<std::vector<int> > &plan) {
   printf("best_price = %d\n", best_price);
 
   for (int semester = 0;
        semester < static_cast<int>(plan.size()); semester++) {
     printf("Semester %d:", semester);
 
-    for (std::vector<int>::iterator course_itr = plan[semester].begin();
+    for (std::vector<int>::const_iterator course_itr = plan[semester].begin();
          course_itr != plan[semester].end(); course_itr++) {
       printf(" %d", *course_itr + 1);
     }
@@ -86,6 +200,8 @@ void minimum_cost_test() {
     printf("\n");
   }
 
+  int num_types = static_cast<int>(semester_prices.size());
+
   for (int semester = 0;
        semester < static_cast<int>(plan.size()); semester++) {
     if (semester > 0) {
@@ -93,24 +209,590 @@ void minimum_cost_test() {
     }
 
     int sum = 0;
-    for (std::vector<int>::iterator course_itr = plan[semester].begin();
+    for (std::vector<int>::const_iterator course_itr = plan[semester].begin();
          course_itr != plan[semester].end(); course_itr++) {
-      if (semester % 2 == 0) {
-        sum += fall_prices[*course_itr];
-      } else {
-        sum += spring_prices[*course_itr];
-      }
+      sum += semester_prices[semester % num_types][*course_itr];
     }
 
     printf("%d", sum);
   }
   printf("\n");
- 
-  printf("} minimum_cost_test\n");
 }
 
-int main() {
+std::vector<std::vector<int> > get_semester_prices(const Problem &problem) {
+  std::vector<std::vector<int> > semester_prices(2);
+  semester_prices[0] = problem.fall_prices;
+  semester_prices[1] = problem.spring_prices;
+
+  return semester_prices;
+}
+
+void print_plan(const Problem &problem, int best_price,
+                const std::vector<std::vector<int> > &plan) {
+  print_plan(get_semester_prices(problem), best_price, plan);
+}
+
+// The price of plan, with semesters cycling through semester_prices.
+int get_plan_cost(const std::vector<std::vector<int> > &semester_prices,
+                  const std::vector<std::vector<int> > &plan) {
+  int num_types = static_cast<int>(semester_prices.size());
+  int cost = 0;
+
+  for (int semester = 0;
+       semester < static_cast<int>(plan.size()); semester++) {
+    for (std::vector<int>::const_iterator course_itr = plan[semester].begin();
+         course_itr != plan[semester].end(); course_itr++) {
+      cost += semester_prices[semester % num_types][*course_itr];
+    }
+  }
+
+  return cost;
+}
+
+void minimum_cost_test() {
+  printf("minimum_cost_test {\n");
+
+  Problem problem;
+  if (!read_problem(kInputFile, &problem)) {
+    printf("Skipped.\n");
+    printf("} minimum_cost_test\n\n");
+    return;
+  }
+
+  std::vector<std::vector<int> > plan;
+
+  SolverTelemetry telemetry;
+  if (!telemetry.create(kTelemetryName)) {
+    printf("Failed to create the telemetry segment.\n");
+  }
+
+  Scheduler scheduler;
+  if (telemetry.counters() != NULL) {
+    scheduler.set_telemetry(&telemetry);
+  }
+
+  int best_price = scheduler.minimum_cost(
+      problem.fall_prices, problem.spring_prices, problem.credits,
+      problem.prerequisites, problem.interesting_courses,
+      problem.c_min, problem.c_max, problem.budget, &plan);
+
+  print_plan(problem, best_price, plan);
+
+  if (telemetry.counters() != NULL) {
+    const TelemetryCounters *counters = telemetry.counters();
+    printf("telemetry: states = %lld, bound_prunes = %lld, "
+           "infeasible_prunes = %lld, incumbent = %d, "
+           "root_lower_bound = %d\n",
+           static_cast<long long>(counters->num_states.load()),
+           static_cast<long long>(counters->num_bound_prunes.load()),
+           static_cast<long long>(counters->num_infeasible_prunes.load()),
+           counters->incumbent_cost.load(),
+           counters->root_lower_bound.load());
+  }
+
+  printf("} minimum_cost_test\n\n");
+}
+
+// Reports progress and then nothing for two rate windows. The current rate
+// must drop to 0 while the average stays positive.
+void telemetry_rate_test() {
+  printf("telemetry_rate_test {\n");
+
+  SolverTelemetry telemetry;
+  if (!telemetry.create(kTelemetryName)) {
+    printf("Failed to create the telemetry segment.\n");
+    printf("} telemetry_rate_test\n\n");
+    return;
+  }
+
+  const TelemetryCounters *counters = telemetry.counters();
+
+  telemetry.start(0);
+  telemetry.add_progress(1000000, 0, 0);
+
+  usleep(kRateWindowMicroseconds);
+  telemetry.add_progress(0, 0, 0);
+  int64_t busy_rate = counters->nodes_per_second.load();
+
+  usleep(kRateWindowMicroseconds);
+  telemetry.add_progress(0, 0, 0);
+  int64_t idle_rate = counters->nodes_per_second.load();
+  int64_t average_rate = counters->average_nodes_per_second.load();
+
+  bool passed = busy_rate > 0 && idle_rate == 0 && average_rate > 0;
+
+  printf("busy_rate = %lld, idle_rate = %lld, average_rate = %lld: %s\n",
+         static_cast<long long>(busy_rate),
+         static_cast<long long>(idle_rate),
+         static_cast<long long>(average_rate),
+         passed ? "PASSED" : "FAILED");
+
+  printf("} telemetry_rate_test\n\n");
+}
+
+// Compares the portfolio with a single search on generated problems. The
+// plan must cost exactly the returned price.
+void portfolio_minimum_cost_test() {
+  printf("portfolio_minimum_cost_test {\n");
+
+  for (unsigned int seed = 1; seed <= kNumGeneratedSeeds; seed++) {
+    Problem problem;
+    generate_problem(seed, 20, 5, &problem);
+
+    std::vector<std::vector<int> > plan;
+
+    Scheduler reference;
+    int expected_price = reference.minimum_cost(
+        problem.fall_prices, problem.spring_prices, problem.credits,
+        problem.prerequisites, problem.interesting_courses,
+        problem.c_min, problem.c_max, problem.budget, &plan);
+
+    Scheduler scheduler;
+    int best_price = scheduler.portfolio_minimum_cost(
+        problem.fall_prices, problem.spring_prices, problem.credits,
+        problem.prerequisites, problem.interesting_courses,
+        problem.c_min, problem.c_max, problem.budget, kNumThreads, &plan);
+
+    print_plan(problem, best_price, plan);
+
+    int plan_cost = get_plan_cost(get_semester_prices(problem), plan);
+    bool passed = best_price == expected_price && plan_cost == best_price;
+
+    printf("seed = %u: expected_price = %d, portfolio_price = %d, "
+           "plan_cost = %d: %s\n",
+           seed, expected_price, best_price, plan_cost,
+           passed ? "PASSED" : "FAILED");
+  }
+
+  printf("} portfolio_minimum_cost_test\n\n");
+}
+
+int64_t get_sum(const std::vector<int64_t> &counts) {
+  int64_t sum = 0;
+  for (std::vector<int64_t>::const_iterator count_itr = counts.begin();
+       count_itr != counts.end(); count_itr++) {
+    sum += *count_itr;
+  }
+
+  return sum;
+}
+
+// Profiles complete solves of generated problems. Every node is counted
+// once by depth and once by semester, and every node but the root is in
+// exactly one top-level branch.
+void search_profile_test() {
+  printf("search_profile_test {\n");
+
+  for (unsigned int seed = 1; seed <= kNumGeneratedSeeds; seed++) {
+    Problem problem;
+    generate_problem(seed, 20, 5, &problem);
+
+    std::vector<std::vector<int> > plan;
+
+    SearchProfile profile;
+
+    Scheduler scheduler;
+    scheduler.set_profile(&profile);
+
+    scheduler.minimum_cost(
+        problem.fall_prices, problem.spring_prices, problem.credits,
+        problem.prerequisites, problem.interesting_courses,
+        problem.c_min, problem.c_max, problem.budget, &plan);
+
+    int64_t num_nodes = profile.num_nodes();
+    int64_t nodes_by_semester = get_sum(profile.nodes_by_semester());
+    int64_t branch_nodes = get_sum(profile.branch_sizes());
+
+    bool passed = num_nodes > 0
+                  && get_sum(profile.nodes_by_depth()) == num_nodes
+                  && nodes_by_semester == num_nodes
+                  && branch_nodes == num_nodes - 1;
+
+    printf("seed = %u: num_nodes = %lld, nodes_by_semester = %lld, "
+           "branch_nodes = %lld: %s\n",
+           seed, static_cast<long long>(num_nodes),
+           static_cast<long long>(nodes_by_semester),
+           static_cast<long long>(branch_nodes),
+           passed ? "PASSED" : "FAILED");
+
+    if (seed == 1) {
+      if (profile.write_json(kProfileFile)) {
+        printf("Wrote the profile to %s.\n", kProfileFile);
+      } else {
+        printf("Failed to write the profile to %s.\n", kProfileFile);
+      }
+    }
+  }
+
+  printf("} search_profile_test\n\n");
+}
+
+// The N-type overload with two semester types must give the same price and
+// plan as the Fall/Spring overload.
+void two_semester_types_test() {
+  printf("two_semester_types_test {\n");
+
+  for (unsigned int seed = 1; seed <= kNumGeneratedSeeds; seed++) {
+    Problem problem;
+    generate_problem(seed, 20, 5, &problem);
+
+    std::vector<std::vector<int> > expected_plan, plan;
+
+    Scheduler scheduler;
+    int expected_price = scheduler.minimum_cost(
+        problem.fall_prices, problem.spring_prices, problem.credits,
+        problem.prerequisites, problem.interesting_courses,
+        problem.c_min, problem.c_max, problem.budget, &expected_plan);
+
+    int best_price = scheduler.minimum_cost(
+        get_semester_prices(problem), problem.credits, problem.prerequisites,
+        problem.interesting_courses, std::vector<int>(2, problem.c_min),
+        std::vector<int>(2, problem.c_max), problem.budget, &plan);
+
+    bool passed = best_price == expected_price && plan == expected_plan;
+
+    printf("seed = %u: expected_price = %d, best_price = %d: %s\n",
+           seed, expected_price, best_price, passed ? "PASSED" : "FAILED");
+  }
+
+  printf("} two_semester_types_test\n\n");
+}
+
+// Fall, Spring and a Summer term with no minimum credits. Course 1 needs
+// course 0, and both are only cheap in Fall. Spring must hold 3 credits,
+// and filler course 2 is the cheapest way to do that. So the only plan
+// costing 4 is Fall {0}, Spring {2}, an empty Summer and Fall {1}. Every
+// other plan takes a course at a price of 50.
+void multi_semester_minimum_cost_test() {
+  printf("multi_semester_minimum_cost_test {\n");
+
+  std::vector<std::vector<int> > semester_prices(3, std::vector<int>(3));
+  semester_prices[0][0] = 1;
+  semester_prices[1][0] = 50;
+  semester_prices[2][0] = 50;
+  semester_prices[0][1] = 1;
+  semester_prices[1][1] = 50;
+  semester_prices[2][1] = 50;
+  semester_prices[0][2] = 50;
+  semester_prices[1][2] = 2;
+  semester_prices[2][2] = 50;
+
+  std::vector<int> credits(3, 3);
+  std::vector<std::vector<int> > prerequisites(3);
+  prerequisites[1].push_back(0);
+  std::vector<int> interesting_courses(1, 1);
+
+  std::vector<int> c_mins(3, 3), c_maxs(3, 3);
+  c_mins[2] = 0;
+
+  std::vector<std::vector<int> > expected_plan(4);
+  expected_plan[0].push_back(0);
+  expected_plan[1].push_back(2);
+  expected_plan[3].push_back(1);
+
+  std::vector<std::vector<int> > plan;
+
+  Scheduler scheduler;
+  int best_price = scheduler.minimum_cost(
+      semester_prices, credits, prerequisites, interesting_courses,
+      c_mins, c_maxs, -1, &plan);
+
+  print_plan(semester_prices, best_price, plan);
+
+  bool passed = best_price == 4 && plan == expected_plan
+                && get_plan_cost(semester_prices, plan) == best_price;
+
+  printf("expected_price = 4, best_price = %d: %s\n",
+         best_price, passed ? "PASSED" : "FAILED");
+
+  printf("} multi_semester_minimum_cost_test\n\n");
+}
+
+// Solves a problem in slices of kResumeStateLimit states, each run
+// resuming from the checkpoint of the previous one, and compares the result
+// with an uninterrupted solve.
+void checkpoint_resume_test() {
+  printf("checkpoint_resume_test {\n");
+
+  Problem problem;
+  generate_problem(kResumeSeed, 30, 6, &problem);
+
+  for (int variant = 0; variant < 2; variant++) {
+    SearchOptions options;
+    options.next_semester_first = (variant == 1);
+
+    std::vector<std::vector<int> > plan;
+
+    Scheduler reference;
+    reference.set_options(options);
+    int expected_price = reference.minimum_cost(
+        problem.fall_prices, problem.spring_prices, problem.credits,
+        problem.prerequisites, problem.interesting_courses,
+        problem.c_min, problem.c_max, problem.budget, &plan);
+
+    remove(kCheckpointFile);
+
+    // Without checkpoints a stopped solve cannot be resumed, but it must
+    // still report that it stopped.
+    Scheduler limited;
+    limited.set_options(options);
+    limited.set_state_limit(kResumeStateLimit);
+    limited.minimum_cost(
+        problem.fall_prices, problem.spring_prices, problem.credits,
+        problem.prerequisites, problem.interesting_courses,
+        problem.c_min, problem.c_max, problem.budget, &plan);
+
+    SolverTelemetry telemetry;
+    if (!telemetry.create(kTelemetryName)) {
+      printf("Failed to create the telemetry segment.\n");
+    }
+
+    int best_price = -1;
+    int num_runs = 0;
+    bool stopped = false;
+    bool consistent = true;
+
+    do {
+      Scheduler scheduler;
+      scheduler.set_options(options);
+      if (telemetry.counters() != NULL) {
+        scheduler.set_telemetry(&telemetry);
+      }
+      scheduler.set_checkpoint(kCheckpointFile, 0);
+      scheduler.set_state_limit(kResumeStateLimit);
+
+      best_price = scheduler.minimum_cost(
+          problem.fall_prices, problem.spring_prices, problem.credits,
+          problem.prerequisites, problem.interesting_courses,
+          problem.c_min, problem.c_max, problem.budget, &plan);
+
+      num_runs++;
+      stopped = scheduler.stopped();
+
+      // Only a stopped solve leaves its checkpoint behind.
+      consistent = consistent && stopped == file_exists(kCheckpointFile);
+
+      // Telemetry tells a stopped solve from a finished one, and shows the
+      // incumbent even if it was restored from the checkpoint. A stopped
+      // solve still shows where it stopped, which is below the root.
+      const TelemetryCounters *counters = telemetry.counters();
+      if (counters != NULL) {
+        consistent = consistent
+                     && (counters->stopped.load() != 0) == stopped
+                     && (counters->finished.load() != 0) == !stopped
+                     && counters->incumbent_cost.load() == best_price
+                     && (!stopped || counters->current_depth.load() > 0);
+      }
+    } while (stopped && consistent && num_runs < kMaxResumeRuns);
+
+    bool passed = !reference.stopped() && limited.stopped() && consistent
+                  && !stopped && num_runs > 1
+                  && best_price == expected_price;
+
+    printf("next_semester_first = %d: expected_price = %d, "
+           "resumed_price = %d, num_runs = %d: %s\n",
+           options.next_semester_first ? 1 : 0, expected_price, best_price,
+           num_runs, passed ? "PASSED" : "FAILED");
+
+    remove(kCheckpointFile);
+  }
+
+  printf("} checkpoint_resume_test\n\n");
+}
+
+void write_text(const char *file_name, const char *text) {
+  FILE *fout = fopen(file_name, "w");
+  if (fout != NULL) {
+    fputs(text, fout);
+    fclose(fout);
+  }
+}
+
+// Corrupt checkpoints must be rejected, and never hand out a plan with
+// courses which do not exist.
+void corrupt_checkpoint_test() {
+  printf("corrupt_checkpoint_test {\n");
+
+  SearchCheckpoint checkpoint;
+
+  // A semester count far beyond any real plan.
+  write_text(kCheckpointFile,
+             "course_scheduler_checkpoint 1\n0\n-1\n2000000000\n");
+  bool huge_rejected = !checkpoint.read(kCheckpointFile);
+
+  // A semester which lists fewer courses than it claims.
+  write_text(kCheckpointFile,
+             "course_scheduler_checkpoint 1\n0\n-1\n1\n3 5 6\n");
+  bool truncated_rejected = !checkpoint.read(kCheckpointFile)
+                            && checkpoint.plan.size() == 1
+                            && checkpoint.plan[0].size() == 2;
+
+  printf("huge: %s, truncated: %s\n",
+         huge_rejected ? "PASSED" : "FAILED",
+         truncated_rejected ? "PASSED" : "FAILED");
+
+  // A checkpoint of the right problem, whose incumbent is cheaper than the
+  // minimum but takes a course which does not exist.
+  Problem problem;
+  generate_problem(kCorruptSeed, 20, 5, &problem);
+
+  std::vector<std::vector<int> > plan;
+
+  Scheduler reference;
+  int expected_price = reference.minimum_cost(
+      problem.fall_prices, problem.spring_prices, problem.credits,
+      problem.prerequisites, problem.interesting_courses,
+      problem.c_min, problem.c_max, problem.budget, &plan);
+
+  remove(kCheckpointFile);
+
+  Scheduler limited;
+  limited.set_checkpoint(kCheckpointFile, 0);
+  limited.set_state_limit(kCorruptStateLimit);
+  limited.minimum_cost(
+      problem.fall_prices, problem.spring_prices, problem.credits,
+      problem.prerequisites, problem.interesting_courses,
+      problem.c_min, problem.c_max, problem.budget, &plan);
+
+  bool corrupted = limited.stopped() && checkpoint.read(kCheckpointFile);
+  if (corrupted) {
+    checkpoint.best_price = 1;
+    checkpoint.plan.assign(1, std::vector<int>(1, 999));
+    corrupted = checkpoint.write(kCheckpointFile);
+  }
+
+  Scheduler scheduler;
+  scheduler.set_checkpoint(kCheckpointFile, 0);
+  int best_price = scheduler.minimum_cost(
+      problem.fall_prices, problem.spring_prices, problem.credits,
+      problem.prerequisites, problem.interesting_courses,
+      problem.c_min, problem.c_max, problem.budget, &plan);
+
+  bool passed = corrupted && best_price == expected_price
+                && get_plan_cost(get_semester_prices(problem), plan)
+                   == best_price;
+
+  printf("bad plan: expected_price = %d, best_price = %d: %s\n",
+         expected_price, best_price, passed ? "PASSED" : "FAILED");
+
+  remove(kCheckpointFile);
+
+  printf("} corrupt_checkpoint_test\n\n");
+}
+
+void checkpoint_progress_test() {
+  printf("checkpoint_progress_test {\n");
+
+  Problem problem;
+  generate_problem(kProgressSeed, kProgressNumCourses,
+                   kProgressNumInterestingCourses, &problem);
+
+  remove(kCheckpointFile);
+
+  std::atomic<bool> done(false);
+  std::vector<std::vector<int> > plan;
+
+  Scheduler scheduler;
+  scheduler.set_checkpoint(kCheckpointFile, kProgressCheckpointInterval);
+  scheduler.set_state_limit(kProgressStateLimit);
+
+  std::thread solver([&]() {
+    scheduler.minimum_cost(
+        problem.fall_prices, problem.spring_prices, problem.credits,
+        problem.prerequisites, problem.interesting_courses,
+        problem.c_min, problem.c_max, problem.budget, &plan);
+    done.store(true);
+  });
+
+  // The longest time the modification time of the checkpoint stayed the
+  // same, after the first checkpoint.
+  time_t last_mtime = 0;
+  int seconds_since_change = 0;
+  int max_gap = 0;
+  int elapsed_seconds = 0;
+
+  while (!done.load()) {
+    sleep(1);
+    elapsed_seconds++;
+
+    struct stat file_stat;
+    if (stat(kCheckpointFile, &file_stat) != 0) {
+      continue;
+    }
+
+    if (file_stat.st_mtime != last_mtime) {
+      last_mtime = file_stat.st_mtime;
+      seconds_since_change = 0;
+    } else if (!done.load()) {
+      seconds_since_change++;
+      max_gap = std::max(max_gap, seconds_since_change);
+    }
+  }
+
+  solver.join();
+
+  // The solve only leaves the checkpoint behind if it reached the state
+  // limit, past 2^31 states.
+  bool passed = file_exists(kCheckpointFile) && last_mtime != 0
+                && max_gap <= kProgressMaxGap;
+
+  printf("elapsed = %ds, max_gap = %ds: %s\n",
+         elapsed_seconds, max_gap, passed ? "PASSED" : "FAILED");
+
+  remove(kCheckpointFile);
+
+  printf("} checkpoint_progress_test\n\n");
+}
+
+void invalid_semester_types_test() {
+  printf("invalid_semester_types_test {\n");
+
+  std::vector<int> credits(2, 3);
+  std::vector<std::vector<int> > prerequisites(2);
+  std::vector<int> interesting_courses(1, 1);
+  std::vector<std::vector<int> > plan(1, std::vector<int>(1, 0));
+
+  Scheduler scheduler;
+
+  // No semester type at all.
+  int best_price = scheduler.minimum_cost(
+      std::vector<std::vector<int> >(), credits, prerequisites,
+      interesting_courses, std::vector<int>(), std::vector<int>(), -1, &plan);
+  printf("no types: best_price = %d, plan size = %d: %s\n",
+         best_price, static_cast<int>(plan.size()),
+         (best_price == -1 && plan.empty()) ? "PASSED" : "FAILED");
+
+  plan.assign(1, std::vector<int>(1, 0));
+
+  // Three semester types, but credit limits for only two.
+  best_price = scheduler.minimum_cost(
+      std::vector<std::vector<int> >(3, std::vector<int>(2, 10)), credits,
+      prerequisites, interesting_courses, std::vector<int>(2, 0),
+      std::vector<int>(2, 6), -1, &plan);
+  printf("mismatched limits: best_price = %d, plan size = %d: %s\n",
+         best_price, static_cast<int>(plan.size()),
+         (best_price == -1 && plan.empty()) ? "PASSED" : "FAILED");
+
+  printf("} invalid_semester_types_test\n\n");
+}
+
+// Pass --long to also run the tests which take minutes.
+int main(int argc, char **argv) {
+  bool run_long_tests = argc > 1 && strcmp(argv[1], "--long") == 0;
+
+  checkpoint_resume_test();
+  corrupt_checkpoint_test();
+  if (run_long_tests) {
+    checkpoint_progress_test();
+  }
+
   minimum_cost_test();
+  telemetry_rate_test();
+  search_profile_test();
+  two_semester_types_test();
+  multi_semester_minimum_cost_test();
+  invalid_semester_types_test();
+  portfolio_minimum_cost_test();
 
   return 0;
 }
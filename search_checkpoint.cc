@@ -0,0 +1,127 @@
+// Author: Mingcheng Chen (linyufly@gmail.com)
+
+#include "search_checkpoint.h"
+
+#include <stdint.h>
+
+#include <cstdio>
+
+#include <string>
+#include <vector>
+
+namespace {
+
+const char *kCheckpointHeader = "course_scheduler_checkpoint";
+const int kCheckpointVersion = 1;
+
+// No list in a checkpoint is longer than this, so a corrupt length cannot
+// make read allocate without bound.
+const int kMaxListLength = 1 << 20;
+
+}
+
+bool SearchCheckpoint::write(const char *file_name) const {
+  std::string temp_file_name = std::string(file_name) + ".tmp";
+
+  FILE *fout = fopen(temp_file_name.c_str(), "w");
+  if (fout == NULL) {
+    return false;
+  }
+
+  fprintf(fout, "%s %d\n", kCheckpointHeader, kCheckpointVersion);
+  fprintf(fout, "%llu\n", static_cast<unsigned long long>(fingerprint));
+  fprintf(fout, "%d\n", best_price);
+
+  fprintf(fout, "%d\n", static_cast<int>(plan.size()));
+  for (std::vector<std::vector<int> >::const_iterator semester_itr =
+       plan.begin();
+       semester_itr != plan.end();
+       semester_itr++) {
+    fprintf(fout, "%d", static_cast<int>(semester_itr->size()));
+    for (std::vector<int>::const_iterator course_itr = semester_itr->begin();
+         course_itr != semester_itr->end();
+         course_itr++) {
+      fprintf(fout, " %d", *course_itr);
+    }
+    fprintf(fout, "\n");
+  }
+
+  fprintf(fout, "%d", static_cast<int>(path.size()));
+  for (std::vector<int>::const_iterator decision_itr = path.begin();
+       decision_itr != path.end();
+       decision_itr++) {
+    fprintf(fout, " %d", *decision_itr);
+  }
+  fprintf(fout, "\n");
+
+  bool success = (fflush(fout) == 0 && !ferror(fout));
+  success = (fclose(fout) == 0) && success;
+
+  if (!success || rename(temp_file_name.c_str(), file_name) != 0) {
+    remove(temp_file_name.c_str());
+    return false;
+  }
+
+  return true;
+}
+
+bool SearchCheckpoint::read(const char *file_name) {
+  FILE *fin = fopen(file_name, "r");
+  if (fin == NULL) {
+    return false;
+  }
+
+  char header[64];
+  int version;
+  unsigned long long file_fingerprint;
+  int num_semesters;
+
+  bool success =
+      fscanf(fin, "%63s %d", header, &version) == 2
+      && std::string(header) == kCheckpointHeader
+      && version == kCheckpointVersion
+      && fscanf(fin, "%llu", &file_fingerprint) == 1
+      && fscanf(fin, "%d", &best_price) == 1
+      && fscanf(fin, "%d", &num_semesters) == 1
+      && num_semesters >= 0 && num_semesters <= kMaxListLength;
+
+  if (success) {
+    fingerprint = file_fingerprint;
+    plan.clear();
+    plan.resize(num_semesters);
+  }
+
+  for (int semester = 0; success && semester < num_semesters; semester++) {
+    int num_courses;
+    success = fscanf(fin, "%d", &num_courses) == 1
+              && num_courses >= 0 && num_courses <= kMaxListLength;
+
+    for (int count = 0; success && count < num_courses; count++) {
+      int course_id;
+      success = fscanf(fin, "%d", &course_id) == 1;
+      if (success) {
+        plan[semester].push_back(course_id);
+      }
+    }
+  }
+
+  int path_length;
+  success = success && fscanf(fin, "%d", &path_length) == 1
+            && path_length >= 0 && path_length <= kMaxListLength;
+
+  if (success) {
+    path.clear();
+  }
+
+  for (int count = 0; success && count < path_length; count++) {
+    int decision;
+    success = fscanf(fin, "%d", &decision) == 1;
+    if (success) {
+      path.push_back(decision);
+    }
+  }
+
+  fclose(fin);
+
+  return success;
+}
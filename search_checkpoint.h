@@ -0,0 +1,35 @@
+// Author: Mingcheng Chen (linyufly@gmail.com)
+
+#ifndef SEARCH_CHECKPOINT_H_
+#define SEARCH_CHECKPOINT_H_
+
+#include <stdint.h>
+
+#include <vector>
+
+// A snapshot of a DFS which is enough to continue it in a later run.
+// Every branch before path is fully explored, and the node path leads to
+// is not explored yet.
+struct SearchCheckpoint {
+  // Identifies the problem and the search options the snapshot is for.
+  uint64_t fingerprint;
+
+  // The best price and plan found so far. best_price is -1 if no solution
+  // is found yet.
+  int best_price;
+  std::vector<std::vector<int> > plan;
+
+  // The decisions from the root: a course id for taking the course in the
+  // current semester, or -1 for moving on to the next semester.
+  std::vector<int> path;
+
+  // Writes to a temporary file first, so an interrupted write never
+  // clobbers the previous checkpoint. Returns false on failure.
+  bool write(const char *file_name) const;
+
+  // Returns false if the file is missing or malformed. Course ids are not
+  // checked against the problem, which is left to the caller.
+  bool read(const char *file_name);
+};
+
+#endif  // SEARCH_CHECKPOINT_H_
@@ -0,0 +1,93 @@
+// Author: Mingcheng Chen (linyufly@gmail.com)
+
+#include "search_profile.h"
+
+#include <stdint.h>
+
+#include <cstdio>
+
+#include <vector>
+
+void SearchProfile::clear() {
+  nodes_by_depth_.clear();
+  bound_prunes_by_depth_.clear();
+  infeasible_by_depth_.clear();
+  nodes_by_semester_.clear();
+  branch_courses_.clear();
+  branch_sizes_.clear();
+}
+
+int64_t SearchProfile::num_nodes() const {
+  int64_t num_nodes = 0;
+  for (std::vector<int64_t>::const_iterator count_itr =
+       nodes_by_depth_.begin();
+       count_itr != nodes_by_depth_.end();
+       count_itr++) {
+    num_nodes += *count_itr;
+  }
+
+  return num_nodes;
+}
+
+bool SearchProfile::write_json(const char *file_name) const {
+  FILE *fout = fopen(file_name, "w");
+  if (fout == NULL) {
+    return false;
+  }
+
+  fprintf(fout, "{\n");
+  fprintf(fout, "  \"num_nodes\": %lld,\n",
+          static_cast<long long>(num_nodes()));
+
+  fprintf(fout, "  \"by_semester\": [");
+  for (int semester = 0;
+       semester < static_cast<int>(nodes_by_semester_.size()); semester++) {
+    fprintf(fout, "%s\n    {\"semester\": %d, \"nodes\": %lld}",
+            semester > 0 ? "," : "", semester,
+            static_cast<long long>(nodes_by_semester_[semester]));
+  }
+  fprintf(fout, "\n  ],\n");
+
+  // The prune rate is the fraction of the nodes at the depth cut by the
+  // bound.
+  fprintf(fout, "  \"by_depth\": [");
+  for (int depth = 0;
+       depth < static_cast<int>(nodes_by_depth_.size()); depth++) {
+    double prune_rate = 0.0;
+    if (nodes_by_depth_[depth] > 0) {
+      prune_rate = static_cast<double>(bound_prunes_by_depth_[depth])
+                   / nodes_by_depth_[depth];
+    }
+
+    fprintf(fout,
+            "%s\n    {\"depth\": %d, \"nodes\": %lld, \"bound_prunes\": %lld, "
+            "\"prune_rate\": %.6f, \"infeasible_candidates\": %lld}",
+            depth > 0 ? "," : "", depth,
+            static_cast<long long>(nodes_by_depth_[depth]),
+            static_cast<long long>(bound_prunes_by_depth_[depth]),
+            prune_rate,
+            static_cast<long long>(infeasible_by_depth_[depth]));
+  }
+  fprintf(fout, "\n  ],\n");
+
+  // A null course stands for moving on to the next semester.
+  fprintf(fout, "  \"top_level_branches\": [");
+  for (int branch = 0;
+       branch < static_cast<int>(branch_sizes_.size()); branch++) {
+    fprintf(fout, "%s\n    {\"course\": ", branch > 0 ? "," : "");
+    if (branch_courses_[branch] == -1) {
+      fprintf(fout, "null");
+    } else {
+      fprintf(fout, "%d", branch_courses_[branch]);
+    }
+    fprintf(fout, ", \"subtree_nodes\": %lld}",
+            static_cast<long long>(branch_sizes_[branch]));
+  }
+  fprintf(fout, "\n  ]\n");
+
+  fprintf(fout, "}\n");
+
+  fclose(fout);
+
+  return true;
+}
@@ -0,0 +1,83 @@
+// Author: Mingcheng Chen (linyufly@gmail.com)
+
+#ifndef SEARCH_PROFILE_H_
+#define SEARCH_PROFILE_H_
+
+#include <stdint.h>
+
+#include <vector>
+
+// Shape of a DFS search tree. Filled by Scheduler when set_profile is given
+// one; the unprofiled search does not touch it at all.
+class SearchProfile {
+ public:
+  void clear();
+
+  void record_node(int depth, int semester) {
+    grow(depth, &nodes_by_depth_);
+    grow(depth, &bound_prunes_by_depth_);
+    grow(depth, &infeasible_by_depth_);
+    grow(semester, &nodes_by_semester_);
+
+    nodes_by_depth_[depth]++;
+    nodes_by_semester_[semester]++;
+
+    if (!branch_sizes_.empty()) {
+      branch_sizes_.back()++;
+    }
+  }
+
+  // The node at depth is cut by the bound.
+  void record_bound_prune(int depth) {
+    bound_prunes_by_depth_[depth]++;
+  }
+
+  // A candidate course of the node at depth cannot be taken.
+  void record_infeasible(int depth) {
+    infeasible_by_depth_[depth]++;
+  }
+
+  // The search enters the next branch of the root. course is -1 for moving
+  // on to the next semester.
+  void begin_branch(int course) {
+    branch_courses_.push_back(course);
+    branch_sizes_.push_back(0);
+  }
+
+  // The total number of nodes, including the root.
+  int64_t num_nodes() const;
+
+  const std::vector<int64_t> &nodes_by_depth() const {
+    return nodes_by_depth_;
+  }
+
+  const std::vector<int64_t> &nodes_by_semester() const {
+    return nodes_by_semester_;
+  }
+
+  // The number of nodes under each branch of the root, in the order the
+  // branches are entered. The root itself is in none of them.
+  const std::vector<int64_t> &branch_sizes() const {
+    return branch_sizes_;
+  }
+
+  // Writes the profile as JSON. Returns false on failure.
+  bool write_json(const char *file_name) const;
+
+ private:
+  static void grow(int index, std::vector<int64_t> *counts) {
+    if (index >= static_cast<int>(counts->size())) {
+      counts->resize(index + 1, 0);
+    }
+  }
+
+  std::vector<int64_t> nodes_by_depth_;
+  std::vector<int64_t> bound_prunes_by_depth_;
+  std::vector<int64_t> infeasible_by_depth_;
+  std::vector<int64_t> nodes_by_semester_;
+
+  std::vector<int> branch_courses_;
+  std::vector<int64_t> branch_sizes_;
+};
+
+#endif  // SEARCH_PROFILE_H_
@@ -0,0 +1,204 @@
+// Author: Mingcheng Chen (linyufly@gmail.com)
+
+#include "solver_telemetry.h"
+
+#include <fcntl.h>
+#include <stdint.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <cstdio>
+
+#include <chrono>
+#include <new>
+
+namespace {
+
+const uint32_t kTelemetryMagic = 0x43535450;  // "CSTP"
+
+// nodes_per_second is measured over at least this long.
+const int64_t kRateWindowNs = 500000000;
+
+int64_t now_ns() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+}
+
+SolverTelemetry::SolverTelemetry() :
+    counters_(NULL), owner_(false), start_ns_(0), window_start_ns_(0),
+    window_start_states_(0) {
+  name_[0] = '\0';
+}
+
+SolverTelemetry::~SolverTelemetry() {
+  close();
+}
+
+bool SolverTelemetry::create(const char *name) {
+  close();
+
+  int fd = shm_open(name, O_CREAT | O_RDWR, 0644);
+  if (fd == -1) {
+    perror("shm_open");
+    return false;
+  }
+
+  if (ftruncate(fd, sizeof(TelemetryCounters)) == -1) {
+    perror("ftruncate");
+    ::close(fd);
+    return false;
+  }
+
+  void *address = mmap(NULL, sizeof(TelemetryCounters),
+                       PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  ::close(fd);
+
+  if (address == MAP_FAILED) {
+    perror("mmap");
+    return false;
+  }
+
+  counters_ = new (address) TelemetryCounters();
+  counters_->finished.store(0);
+  counters_->stopped.store(0);
+  counters_->num_states.store(0);
+  counters_->num_bound_prunes.store(0);
+  counters_->num_infeasible_prunes.store(0);
+  counters_->current_depth.store(0);
+  counters_->current_semester.store(0);
+  counters_->incumbent_cost.store(-1);
+  counters_->root_lower_bound.store(0);
+  counters_->nodes_per_second.store(0);
+  counters_->average_nodes_per_second.store(0);
+  counters_->elapsed_ms.store(0);
+  counters_->magic.store(kTelemetryMagic, std::memory_order_release);
+
+  snprintf(name_, sizeof(name_), "%s", name);
+  owner_ = true;
+
+  return true;
+}
+
+bool SolverTelemetry::attach(const char *name) {
+  close();
+
+  int fd = shm_open(name, O_RDONLY, 0);
+  if (fd == -1) {
+    return false;
+  }
+
+  void *address = mmap(NULL, sizeof(TelemetryCounters),
+                       PROT_READ, MAP_SHARED, fd, 0);
+  ::close(fd);
+
+  if (address == MAP_FAILED) {
+    return false;
+  }
+
+  counters_ = static_cast<TelemetryCounters *>(address);
+
+  if (counters_->magic.load(std::memory_order_acquire) != kTelemetryMagic) {
+    close();
+    return false;
+  }
+
+  snprintf(name_, sizeof(name_), "%s", name);
+  owner_ = false;
+
+  return true;
+}
+
+void SolverTelemetry::close() {
+  if (counters_ == NULL) {
+    return;
+  }
+
+  munmap(counters_, sizeof(TelemetryCounters));
+  counters_ = NULL;
+
+  if (owner_) {
+    shm_unlink(name_);
+    owner_ = false;
+  }
+}
+
+void SolverTelemetry::start(int root_lower_bound) {
+  start_ns_ = now_ns();
+  window_start_ns_ = start_ns_;
+  window_start_states_ = 0;
+
+  counters_->finished.store(0, std::memory_order_relaxed);
+  counters_->stopped.store(0, std::memory_order_relaxed);
+  counters_->num_states.store(0, std::memory_order_relaxed);
+  counters_->num_bound_prunes.store(0, std::memory_order_relaxed);
+  counters_->num_infeasible_prunes.store(0, std::memory_order_relaxed);
+  counters_->incumbent_cost.store(-1, std::memory_order_relaxed);
+  counters_->root_lower_bound.store(
+      root_lower_bound, std::memory_order_relaxed);
+  counters_->nodes_per_second.store(0, std::memory_order_relaxed);
+  counters_->average_nodes_per_second.store(0, std::memory_order_relaxed);
+  counters_->elapsed_ms.store(0, std::memory_order_relaxed);
+}
+
+void SolverTelemetry::add_progress(
+    int64_t num_states, int64_t num_bound_prunes,
+    int64_t num_infeasible_prunes) {
+  counters_->num_states.fetch_add(num_states, std::memory_order_relaxed);
+  counters_->num_bound_prunes.fetch_add(
+      num_bound_prunes, std::memory_order_relaxed);
+  counters_->num_infeasible_prunes.fetch_add(
+      num_infeasible_prunes, std::memory_order_relaxed);
+
+  update_rate();
+}
+
+void SolverTelemetry::set_position(int current_depth, int current_semester) {
+  counters_->current_depth.store(current_depth, std::memory_order_relaxed);
+  counters_->current_semester.store(
+      current_semester, std::memory_order_relaxed);
+}
+
+void SolverTelemetry::set_incumbent_cost(int cost) {
+  counters_->incumbent_cost.store(cost, std::memory_order_relaxed);
+}
+
+void SolverTelemetry::finish() {
+  update_rate();
+  counters_->finished.store(1, std::memory_order_release);
+}
+
+void SolverTelemetry::stop() {
+  update_rate();
+  counters_->stopped.store(1, std::memory_order_release);
+}
+
+void SolverTelemetry::update_rate() {
+  std::lock_guard<std::mutex> lock(rate_mutex_);
+
+  int64_t now = now_ns();
+  int64_t elapsed_ns = now - start_ns_;
+  if (elapsed_ns <= 0) {
+    return;
+  }
+
+  int64_t num_states = counters_->num_states.load(std::memory_order_relaxed);
+
+  counters_->average_nodes_per_second.store(
+      static_cast<int64_t>(num_states * 1e9 / elapsed_ns),
+      std::memory_order_relaxed);
+  counters_->elapsed_ms.store(elapsed_ns / 1000000,
+                              std::memory_order_relaxed);
+
+  int64_t window_ns = now - window_start_ns_;
+  if (window_ns >= kRateWindowNs) {
+    counters_->nodes_per_second.store(
+        static_cast<int64_t>(
+            (num_states - window_start_states_) * 1e9 / window_ns),
+        std::memory_order_relaxed);
+
+    window_start_ns_ = now;
+    window_start_states_ = num_states;
+  }
+}
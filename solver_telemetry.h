@@ -0,0 +1,109 @@
+// Author: Mingcheng Chen (linyufly@gmail.com)
+
+#ifndef SOLVER_TELEMETRY_H_
+#define SOLVER_TELEMETRY_H_
+
+#include <stdint.h>
+
+#include <atomic>
+#include <mutex>
+
+// Layout of the shared-memory segment. All the fields are lock-free atomics
+// so that the solver never blocks on a reader.
+struct TelemetryCounters {
+  // Equals kTelemetryMagic once the segment is initialized.
+  std::atomic<uint32_t> magic;
+
+  // Non-zero after the solve has explored its whole search space and
+  // returned.
+  std::atomic<int32_t> finished;
+
+  // Non-zero after the solve has returned early at its state limit, so
+  // incumbent_cost is not proven to be the minimum.
+  std::atomic<int32_t> stopped;
+
+  std::atomic<int64_t> num_states;
+  std::atomic<int64_t> num_bound_prunes;
+  std::atomic<int64_t> num_infeasible_prunes;
+
+  // Where the most recently reporting search currently is.
+  std::atomic<int32_t> current_depth;
+  std::atomic<int32_t> current_semester;
+
+  // -1 if no solution is found yet.
+  std::atomic<int32_t> incumbent_cost;
+
+  // Lower bound of the minimum cost computed at the root: every required
+  // course at its cheapest price. It is set once per solve and does not
+  // tighten as the search proceeds.
+  std::atomic<int32_t> root_lower_bound;
+
+  // Averaged over the last rate window of the solve, so a solve which
+  // slows down shows it quickly.
+  std::atomic<int64_t> nodes_per_second;
+
+  // Averaged over the whole solve.
+  std::atomic<int64_t> average_nodes_per_second;
+
+  // Milliseconds since the solve started, at the last update. A value which
+  // stops growing means the solver has stopped reporting.
+  std::atomic<int64_t> elapsed_ms;
+};
+
+// Atomics are only safe to share between processes if they never fall back
+// to a lock, which would live in the memory of one process.
+static_assert(ATOMIC_INT_LOCK_FREE == 2,
+              "32-bit atomics must be lock-free to be shared");
+static_assert(ATOMIC_LONG_LOCK_FREE == 2 && ATOMIC_LLONG_LOCK_FREE == 2,
+              "64-bit atomics must be lock-free to be shared");
+
+class SolverTelemetry {
+ public:
+  SolverTelemetry();
+  ~SolverTelemetry();
+
+  // Creates (or truncates) the segment name, e.g. "/course_scheduler".
+  // Returns false on failure.
+  bool create(const char *name);
+
+  // Maps an existing segment read-only. Returns false on failure or if the
+  // segment is not initialized.
+  bool attach(const char *name);
+
+  // Unmaps the segment, and removes it if it was created by this object.
+  void close();
+
+  const TelemetryCounters *counters() const {
+    return counters_;
+  }
+
+  // The following are only for the writer.
+  void start(int root_lower_bound);
+
+  void add_progress(int64_t num_states, int64_t num_bound_prunes,
+                    int64_t num_infeasible_prunes);
+
+  void set_position(int current_depth, int current_semester);
+
+  void set_incumbent_cost(int cost);
+
+  void finish();
+
+  void stop();
+
+ private:
+  void update_rate();
+
+  TelemetryCounters *counters_;
+  char name_[256];
+  bool owner_;
+  int64_t start_ns_;
+
+  // Where the current rate window started. Guarded by rate_mutex_, as the
+  // searches of a portfolio report from different threads.
+  std::mutex rate_mutex_;
+  int64_t window_start_ns_;
+  int64_t window_start_states_;
+};
+
+#endif  // SOLVER_TELEMETRY_H_
@@ -0,0 +1,76 @@
+// Author: Mingcheng Chen (linyufly@gmail.com)
+
+// Attaches to the telemetry segment of a running solve and prints its
+// counters once per second until the solve finishes or stops.
+//
+// Usage: TelemetryMonitor [segment_name]
+
+#include "solver_telemetry.h"
+
+#include <unistd.h>
+
+#include <stdint.h>
+
+#include <cstdio>
+
+const char *kDefaultSegmentName = "/course_scheduler";
+
+// The number of seconds without an update before a solve is reported as
+// stalled.
+const int kStallSeconds = 5;
+
+int main(int argc, char **argv) {
+  const char *segment_name = (argc > 1) ? argv[1] : kDefaultSegmentName;
+
+  SolverTelemetry telemetry;
+
+  printf("Waiting for %s ...\n", segment_name);
+  while (!telemetry.attach(segment_name)) {
+    sleep(1);
+  }
+
+  const TelemetryCounters *counters = telemetry.counters();
+
+  int64_t last_elapsed_ms = -1;
+  int stalled_seconds = 0;
+
+  while (true) {
+    bool finished = counters->finished.load(std::memory_order_acquire) != 0;
+    bool stopped = counters->stopped.load(std::memory_order_acquire) != 0;
+    int64_t elapsed_ms = counters->elapsed_ms.load(std::memory_order_relaxed);
+
+    if (elapsed_ms == last_elapsed_ms) {
+      stalled_seconds++;
+    } else {
+      stalled_seconds = 0;
+    }
+    last_elapsed_ms = elapsed_ms;
+
+    printf("t = %.1fs, states = %lld (%lld/s, average %lld/s), "
+           "bound_prunes = %lld, infeasible_prunes = %lld, depth = %d, "
+           "semester = %d, incumbent = %d, root_lower_bound = %d%s\n",
+           elapsed_ms / 1000.0,
+           static_cast<long long>(counters->num_states.load()),
+           static_cast<long long>(counters->nodes_per_second.load()),
+           static_cast<long long>(
+               counters->average_nodes_per_second.load()),
+           static_cast<long long>(counters->num_bound_prunes.load()),
+           static_cast<long long>(counters->num_infeasible_prunes.load()),
+           counters->current_depth.load(),
+           counters->current_semester.load(),
+           counters->incumbent_cost.load(),
+           counters->root_lower_bound.load(),
+           finished ? " [finished]"
+           : stopped ? " [stopped]"
+           : (stalled_seconds >= kStallSeconds ? " [stalled]" : ""));
+    fflush(stdout);
+
+    if (finished || stopped) {
+      break;
+    }
+
+    sleep(1);
+  }
+
+  return 0;
+}